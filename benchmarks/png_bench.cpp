@@ -0,0 +1,211 @@
+//size and speed of png::save for each filter strategy
+//g++ -std=c++17 -O2 benchmarks/png_bench.cpp yanconv.cpp -o png_bench -pthread
+//png_bench [--levels 1,6,9] [--threads 1,4] [files...]
+//without files it makes its own images, every saved file is read back and compared
+//speedup is against the first thread count, brute_force always compresses on one thread so it stays at 1
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+
+#include "../yanconv.h"
+
+using namespace yconv;
+
+namespace
+{
+    struct sample
+    {
+        std::string name;
+        image img;
+    };
+
+    const std::vector<std::pair<png::filter_strategy, const char*>> strategies{
+        {png::filter_strategy::none, "none"},
+        {png::filter_strategy::sub, "sub"},
+        {png::filter_strategy::up, "up"},
+        {png::filter_strategy::average, "average"},
+        {png::filter_strategy::paeth, "paeth"},
+        {png::filter_strategy::min_sum, "min_sum"},
+        {png::filter_strategy::entropy, "entropy"},
+        {png::filter_strategy::brute_force, "brute_force"}};
+
+    template<typename F>
+    double best_seconds(F function, const int runs = 2)
+    {
+        double best = 1e30;
+        for(int i = 0; i < runs; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now()-start;
+
+            best = std::min(best, duration.count());
+        }
+
+        return best;
+    }
+
+    std::vector<unsigned> parse_list(const char* text)
+    {
+        std::vector<unsigned> values;
+
+        char* end = nullptr;
+        for(const char* c = text; *c!=0; c = *end==',' ? end+1 : end)
+        {
+            values.push_back(std::strtoul(c, &end, 10));
+            if(end==c)
+                break;
+        }
+
+        return values;
+    }
+
+    //rgba gradient with noise in every channel, hard on every filter
+    image gradient_sample(const unsigned width, const unsigned height)
+    {
+        std::mt19937 random(1);
+
+        image img(width, height, 4, std::vector<uint8_t>(static_cast<size_t>(width)*height*4));
+        for(unsigned y = 0; y < height; ++y)
+        {
+            for(unsigned x = 0; x < width; ++x)
+            {
+                uint8_t* pixel = img.data.data()+(static_cast<size_t>(y)*width+x)*4;
+
+                pixel[0] = (x*255/width+random()%8)&0xff;
+                pixel[1] = (y*255/height+random()%8)&0xff;
+                pixel[2] = ((x+y)*127/(width+height)+random()%4)&0xff;
+                pixel[3] = 255-(random()%2);
+            }
+        }
+
+        return img;
+    }
+
+    //rgb shapes over a smooth background with a little noise, like a rendered scene
+    image shapes_sample(const unsigned width, const unsigned height)
+    {
+        std::mt19937 random(2);
+
+        struct circle
+        {
+            int x, y, radius;
+            uint8_t color[3];
+        };
+
+        std::vector<circle> circles(24);
+        for(auto& c : circles)
+        {
+            c.x = random()%width;
+            c.y = random()%height;
+            c.radius = 10+random()%(height/4);
+
+            for(auto& channel : c.color)
+                channel = random()&0xff;
+        }
+
+        image img(width, height, 3, std::vector<uint8_t>(static_cast<size_t>(width)*height*3));
+        for(unsigned y = 0; y < height; ++y)
+        {
+            for(unsigned x = 0; x < width; ++x)
+            {
+                uint8_t* pixel = img.data.data()+(static_cast<size_t>(y)*width+x)*3;
+
+                pixel[0] = 40+y*80/height;
+                pixel[1] = 60+x*60/width;
+                pixel[2] = 120;
+
+                for(const auto& c : circles)
+                {
+                    const int dx = static_cast<int>(x)-c.x;
+                    const int dy = static_cast<int>(y)-c.y;
+                    if(dx*dx+dy*dy<=c.radius*c.radius)
+                        std::copy(c.color, c.color+3, pixel);
+                }
+
+                if(random()%4==0)
+                    pixel[random()%3] ^= 1;
+            }
+        }
+
+        return img;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<unsigned> levels{6};
+    std::vector<unsigned> threads{1, std::max(1u, std::thread::hardware_concurrency())};
+
+    std::vector<sample> samples;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "--levels")==0 && i+1<argc)
+        {
+            levels = parse_list(argv[++i]);
+        } else if(std::strcmp(argv[i], "--threads")==0 && i+1<argc)
+        {
+            threads = parse_list(argv[++i]);
+        } else
+        {
+            samples.push_back({std::filesystem::path(argv[i]).filename().string(), png::read(argv[i])});
+        }
+    }
+
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+    if(samples.empty())
+    {
+        samples.push_back({"gradient", gradient_sample(640, 480)});
+        samples.push_back({"shapes", shapes_sample(1280, 720)});
+    }
+
+    const std::filesystem::path save_path = std::filesystem::temp_directory_path()/"png_bench.png";
+
+    //the speedup past this many threads is just scheduling noise
+    std::printf("%u cores\n", std::thread::hardware_concurrency());
+    std::printf("%-16s %-12s %5s %7s %10s %10s %9s\n", "image", "strategy", "level", "threads", "size", "time", "speedup");
+
+    for(const sample& current : samples)
+    {
+        for(const unsigned level : levels)
+        {
+            for(const auto& [strategy, name] : strategies)
+            {
+                double single_time = 0;
+
+                for(const unsigned threads_num : threads)
+                {
+                    const double time = best_seconds([&](){png::save(current.img.view(), save_path, level, threads_num, strategy);});
+
+                    const image saved = png::read(save_path, true);
+                    if(saved.data!=current.img.data)
+                    {
+                        std::printf("%s with %s at level %u on %u threads doesnt read back the same\n",
+                            current.name.c_str(), name, level, threads_num);
+                        return 1;
+                    }
+
+                    if(threads_num==threads.front())
+                        single_time = time;
+
+                    std::printf("%-16s %-12s %5u %7u %10ju %8.1fms %8.2fx\n", current.name.c_str(), name, level, threads_num,
+                        static_cast<uintmax_t>(std::filesystem::file_size(save_path)), time*1000, single_time/time);
+                }
+            }
+
+            std::printf("\n");
+        }
+    }
+
+    std::filesystem::remove(save_path);
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+//speed of image::resize for each resize_type and of image::mipmaps
+//g++ -std=c++17 -O2 benchmarks/resize_bench.cpp yanconv.cpp -o resize_bench -pthread
+//resize_bench [--threads 1,4] [files...]
+//without files it makes a 4000x3000 rgba image, every thread count has to give the same pixels as the first
+//speedup is against the first thread count
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+
+#include "../yanconv.h"
+
+using namespace yconv;
+
+namespace
+{
+    struct sample
+    {
+        std::string name;
+        image img;
+    };
+
+    struct target
+    {
+        const char* name;
+        unsigned width;
+        unsigned height;
+    };
+
+    const std::vector<std::pair<image::resize_type, const char*>> types{
+        {image::resize_type::nearest_neighbor, "nearest"},
+        {image::resize_type::area_sample, "area_sample"},
+        {image::resize_type::bilinear, "bilinear"},
+        {image::resize_type::catmull_rom, "catmull_rom"},
+        {image::resize_type::mitchell, "mitchell"},
+        {image::resize_type::lanczos, "lanczos"}};
+
+    //resizes a fresh copy every run, the copy isnt timed
+    double best_seconds(const image& source, image& resized, const unsigned width, const unsigned height,
+        const image::resize_type type, const unsigned threads_num, const int runs = 3)
+    {
+        double best = 1e30;
+        for(int i = 0; i < runs; ++i)
+        {
+            resized = source;
+
+            const auto start = std::chrono::steady_clock::now();
+            resized.resize(width, height, type, threads_num);
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now()-start;
+
+            best = std::min(best, duration.count());
+        }
+
+        return best;
+    }
+
+    template<typename F>
+    double best_seconds(F function, const int runs = 3)
+    {
+        double best = 1e30;
+        for(int i = 0; i < runs; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now()-start;
+
+            best = std::min(best, duration.count());
+        }
+
+        return best;
+    }
+
+    std::vector<unsigned> parse_list(const char* text)
+    {
+        std::vector<unsigned> values;
+
+        char* end = nullptr;
+        for(const char* c = text; *c!=0; c = *end==',' ? end+1 : end)
+        {
+            values.push_back(std::strtoul(c, &end, 10));
+            if(end==c)
+                break;
+        }
+
+        return values;
+    }
+
+    //rgba gradient with noise and some hard edges, so every kernel has detail to work on
+    image photo_sample(const unsigned width, const unsigned height)
+    {
+        std::mt19937 random(1);
+
+        image img(width, height, 4, std::vector<uint8_t>(static_cast<size_t>(width)*height*4));
+        for(unsigned y = 0; y < height; ++y)
+        {
+            for(unsigned x = 0; x < width; ++x)
+            {
+                uint8_t* pixel = img.data.data()+(static_cast<size_t>(y)*width+x)*4;
+
+                const bool stripe = (x/37+y/53)%2==0;
+
+                pixel[0] = (x*255/width+random()%16)&0xff;
+                pixel[1] = (y*255/height+random()%16)&0xff;
+                pixel[2] = stripe ? 200 : 30;
+                pixel[3] = 255-(random()%4);
+            }
+        }
+
+        return img;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<unsigned> threads{1, std::max(1u, std::thread::hardware_concurrency())};
+
+    std::vector<sample> samples;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "--threads")==0 && i+1<argc)
+        {
+            threads = parse_list(argv[++i]);
+        } else
+        {
+            samples.push_back({std::filesystem::path(argv[i]).filename().string(), image(argv[i])});
+        }
+    }
+
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+    if(samples.empty())
+        samples.push_back({"photo", photo_sample(4000, 3000)});
+
+    //the speedup past this many threads is just scheduling noise
+    std::printf("%u cores\n", std::thread::hardware_concurrency());
+    std::printf("%-16s %-12s %-12s %7s %10s %9s\n", "image", "target", "type", "threads", "time", "speedup");
+
+    for(const sample& current : samples)
+    {
+        const unsigned width = current.img.width;
+        const unsigned height = current.img.height;
+
+        const std::vector<target> targets{
+            {"quarter", std::max(1u, width/4), std::max(1u, height/4)},
+            {"thumbnail", std::max(1u, width/16), std::max(1u, height/16)},
+            {"just_under", std::max(1u, width/2-1), std::max(1u, height/2-1)},
+            {"double", width*2, height*2}};
+
+        for(const target& size : targets)
+        {
+            for(const auto& [type, name] : types)
+            {
+                image first;
+                double single_time = 0;
+
+                for(const unsigned threads_num : threads)
+                {
+                    image resized;
+                    const double time = best_seconds(current.img, resized, size.width, size.height, type, threads_num);
+
+                    if(threads_num==threads.front())
+                    {
+                        first = std::move(resized);
+                        single_time = time;
+                    } else if(resized.data!=first.data)
+                    {
+                        std::printf("%s %s with %s on %u threads isnt the same as on %u\n",
+                            current.name.c_str(), size.name, name, threads_num, threads.front());
+                        return 1;
+                    }
+
+                    std::printf("%-16s %-12s %-12s %7u %8.1fms %8.2fx\n", current.name.c_str(), size.name, name,
+                        threads_num, time*1000, single_time/time);
+                }
+            }
+
+            std::printf("\n");
+        }
+
+        const std::vector<std::pair<mip_filter, const char*>> filters{
+            {mip_filter::box, "mip_box"},
+            {mip_filter::kaiser, "mip_kaiser"}};
+
+        for(const auto& [filter, name] : filters)
+        {
+            double single_time = 0;
+
+            for(const unsigned threads_num : threads)
+            {
+                const double time = best_seconds([&](){current.img.mipmaps(filter, true, threads_num);});
+
+                if(threads_num==threads.front())
+                    single_time = time;
+
+                std::printf("%-16s %-12s %-12s %7u %8.1fms %8.2fx\n", current.name.c_str(), "chain", name,
+                    threads_num, time*1000, single_time/time);
+            }
+        }
+
+        std::printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,252 @@
+//compression and decompression speed of ydeflate
+//g++ -std=c++17 -O2 benchmarks/ydeflate_bench.cpp yanconv.cpp -o ydeflate_bench -pthread
+//ydeflate_bench [levels] [files...]
+//levels is a list like 0,1,6,9, without files it makes its own corpus
+//pngs are also timed decoding their own IDAT stream as is, to see streams from other encoders
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+#include "../yanconv.h"
+
+using namespace yconv;
+
+namespace
+{
+    struct sample
+    {
+        std::string name;
+        std::vector<uint8_t> data;
+
+        //only for pngs, their image data as it is in the file
+        std::vector<uint8_t> stream;
+    };
+
+    //the fastest of a few runs, the first one warms up the caches
+    template<typename F>
+    double best_seconds(F function, const int runs = 3)
+    {
+        double best = 1e30;
+        for(int i = 0; i < runs; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now()-start;
+
+            best = std::min(best, duration.count());
+        }
+
+        return best;
+    }
+
+    double megabytes(const size_t size) noexcept
+    {
+        return size/(1024.0*1024.0);
+    }
+
+    std::vector<uint8_t> read_file(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    //every IDAT put together, empty if its not a png
+    std::vector<uint8_t> idat_stream(const std::vector<uint8_t>& file)
+    {
+        const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+        if(file.size()<8 || std::memcmp(file.data(), signature, 8)!=0)
+            return {};
+
+        std::vector<uint8_t> stream;
+        for(size_t pos = 8; pos+12 <= file.size();)
+        {
+            const size_t length = (static_cast<size_t>(file[pos])<<24)|(file[pos+1]<<16)|(file[pos+2]<<8)|file[pos+3];
+            if(pos+12+length>file.size())
+                break;
+
+            if(std::memcmp(file.data()+pos+4, "IDAT", 4)==0)
+                stream.insert(stream.end(), file.begin()+pos+8, file.begin()+pos+8+length);
+
+            pos += 12+length;
+        }
+
+        return stream;
+    }
+
+    //text out of a few hundred made up words, picked with a skew like real words have
+    std::vector<uint8_t> text_sample(const size_t size)
+    {
+        std::mt19937 random(1);
+
+        std::vector<std::string> words(400);
+        for(auto& word : words)
+        {
+            const int length = 2+random()%8;
+            for(int i = 0; i < length; ++i)
+                word.push_back('a'+random()%26);
+        }
+
+        std::vector<uint8_t> data;
+        data.reserve(size+16);
+        while(data.size()<size)
+        {
+            //squaring a uniform value makes the first words a lot more common
+            const float pick = std::generate_canonical<float, 24>(random);
+            const std::string& word = words[static_cast<size_t>(pick*pick*words.size())];
+
+            data.insert(data.end(), word.begin(), word.end());
+            data.push_back(random()%12==0 ? '\n' : ' ');
+        }
+
+        data.resize(size);
+        return data;
+    }
+
+    //rgba gradient with a bit of noise, like a rendered frame
+    std::vector<uint8_t> frame_sample(const unsigned width, const unsigned height)
+    {
+        std::mt19937 random(2);
+
+        std::vector<uint8_t> data(static_cast<size_t>(width)*height*4);
+        for(unsigned y = 0; y < height; ++y)
+        {
+            for(unsigned x = 0; x < width; ++x)
+            {
+                uint8_t* pixel = data.data()+(static_cast<size_t>(y)*width+x)*4;
+
+                pixel[0] = (x*255/width+random()%8)&0xff;
+                pixel[1] = (y*255/height+random()%8)&0xff;
+                pixel[2] = ((x+y)*127/(width+height)+random()%4)&0xff;
+                pixel[3] = 255;
+            }
+        }
+
+        return data;
+    }
+
+    std::vector<uint8_t> random_sample(const size_t size)
+    {
+        std::mt19937 random(3);
+
+        std::vector<uint8_t> data(size);
+        for(auto& value : data)
+            value = random()&0xff;
+
+        return data;
+    }
+
+    std::vector<int> parse_levels(const char* text)
+    {
+        std::vector<int> levels;
+        for(const char* c = text; *c!=0; ++c)
+        {
+            if(*c>='0' && *c<='9')
+                levels.push_back(*c-'0');
+        }
+
+        return levels;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<int> levels{0, 1, 2, 6, 9};
+
+    int first_file = 1;
+    if(argc>1 && std::strspn(argv[1], "0123456789,")==std::strlen(argv[1]))
+    {
+        levels = parse_levels(argv[1]);
+        first_file = 2;
+    }
+
+    std::vector<sample> samples;
+    for(int i = first_file; i < argc; ++i)
+    {
+        sample file_sample{argv[i], read_file(argv[i]), {}};
+
+        //a png is compressed as its decoded data, the file itself is mostly incompressible
+        file_sample.stream = idat_stream(file_sample.data);
+        if(!file_sample.stream.empty())
+            file_sample.data = ydeflate::deflate(file_sample.stream);
+
+        samples.push_back(std::move(file_sample));
+    }
+
+    if(samples.empty())
+    {
+        samples.push_back({"text", text_sample(4*1024*1024), {}});
+        samples.push_back({"frame", frame_sample(1280, 720), {}});
+        samples.push_back({"random", random_sample(1024*1024), {}});
+    }
+
+    std::printf("%-24s %5s %12s %10s %12s\n", "sample", "level", "size", "compress", "decompress");
+
+    for(const int level : levels)
+    {
+        size_t total_size = 0;
+        size_t total_compressed = 0;
+        double total_compress = 0;
+        double total_decompress = 0;
+
+        for(const sample& current : samples)
+        {
+            std::vector<uint8_t> compressed;
+            const double compress_time = best_seconds([&](){compressed = ydeflate::inflate(current.data, level);});
+
+            std::vector<uint8_t> decompressed;
+            const double decompress_time = best_seconds([&](){decompressed = ydeflate::deflate(compressed);});
+
+            if(decompressed!=current.data)
+            {
+                std::printf("%s at level %d doesnt decompress to the same data\n", current.name.c_str(), level);
+                return 1;
+            }
+
+            std::printf("%-24s %5d %12zu %7.1fMB/s %9.1fMB/s\n", current.name.c_str(), level, compressed.size(),
+                megabytes(current.data.size())/compress_time, megabytes(current.data.size())/decompress_time);
+
+            total_size += current.data.size();
+            total_compressed += compressed.size();
+            total_compress += compress_time;
+            total_decompress += decompress_time;
+        }
+
+        std::printf("%-24s %5d %12zu %7.1fMB/s %9.1fMB/s  %.1f%% of %zu\n\n", "total", level, total_compressed,
+            megabytes(total_size)/total_compress, megabytes(total_size)/total_decompress,
+            100.0*total_compressed/total_size, total_size);
+    }
+
+    size_t streams_size = 0;
+    size_t streams_decompressed = 0;
+    double streams_time = 0;
+
+    for(const sample& current : samples)
+    {
+        if(current.stream.empty())
+            continue;
+
+        const double decompress_time = best_seconds([&](){ydeflate::deflate(current.stream);});
+
+        std::printf("%-24s %5s %12zu %10s %9.1fMB/s\n", current.name.c_str(), "idat", current.stream.size(), "",
+            megabytes(current.data.size())/decompress_time);
+
+        streams_size += current.stream.size();
+        streams_decompressed += current.data.size();
+        streams_time += decompress_time;
+    }
+
+    if(streams_size!=0)
+    {
+        std::printf("%-24s %5s %12zu %10s %9.1fMB/s\n", "total", "idat", streams_size, "",
+            megabytes(streams_decompressed)/streams_time);
+    }
+
+    return 0;
+}
@@ -355,6 +355,15 @@ texture::texture(const std::string image_path) : _empty(false)
 
 	const std::string extension = image_fpath.filename().extension().string();
 
+	if(extension==".png")
+	{
+		//already flipped and premultiplied while decoding
+		parse_png(image_path);
+		update_buffers();
+
+		return;
+	}
+
 	if(!parse_image(image_path, extension))
 		throw std::runtime_error(std::string("error parsing image: ")
 			+ image_path);
@@ -371,15 +380,36 @@ texture::texture(const default_texture id) : _empty(false)
 	full_setup();
 }
 
-texture::texture(const yconv::image image) : _image(image), _empty(false)
+texture::texture(const yconv::image& image) : texture(image.view())
 {
-	_type = calc_type(image.bpp);
+}
+
+texture::texture(yconv::image&& image) : _image(std::move(image)), _empty(false)
+{
+	_type = calc_type(_image.bpp);
 	_image.flip();
 
 	full_setup();
 }
 
-texture::texture(const int width, const int height, const std::vector<uint8_t> data)
+texture::texture(const yconv::image_view image) : _image(image.flipped()), _empty(false)
+{
+	_type = calc_type(image.bpp);
+
+	full_setup();
+}
+
+texture::texture(const yconv::mip_chain& mips) : _mips(mips), _empty(false)
+{
+	mips_setup();
+}
+
+texture::texture(yconv::mip_chain&& mips) : _mips(std::move(mips)), _empty(false)
+{
+	mips_setup();
+}
+
+texture::texture(const int width, const int height, const std::vector<uint8_t>& data)
 : _empty(false)
 {
 	_image = yconv::image(width, height, data.size()/(width*height), data);
@@ -387,6 +417,15 @@ texture::texture(const int width, const int height, const std::vector<uint8_t> d
 	full_setup();
 }
 
+texture::texture(const int width, const int height, std::vector<uint8_t>&& data)
+: _empty(false)
+{
+	const uint8_t bpp = data.size()/(width*height);
+	_image = yconv::image(width, height, bpp, std::move(data));
+
+	full_setup();
+}
+
 void texture::set_current() const
 {
 	assert(!_empty);
@@ -418,30 +457,25 @@ void texture::full_setup() noexcept
 	update_buffers();
 }
 
+void texture::mips_setup()
+{
+	_image = yconv::image(_mips.width(0), _mips.height(0), _mips.bpp(), {});
+	_type = calc_type(_mips.bpp());
+
+	_has_transparency = _mips.bpp()==4
+		&& yconv::pixels::has_transparency(_mips.data(0), 4, _mips.size(0)/4);
+
+	update_buffers();
+}
+
 void texture::premultiply() noexcept
 {
 	//check if there is an alpha channel
 	if(_image.bpp!=4)
 		return;
 
-	unsigned index = 0;
-	for(int y = 0; y < _image.height; ++y)
-	{
-		for(int x = 0; x < _image.width; ++x, index += _image.bpp)
-		{
-			const uint8_t alpha = _image.pixel_color(x, y, 3);
-			const float mult = alpha/255.0f;
-
-			const uint8_t new_r = _image.pixel_color(x, y, 0) * mult;
-			const uint8_t new_g = _image.pixel_color(x, y, 1) * mult;
-			const uint8_t new_b = _image.pixel_color(x, y, 2) * mult;
-
-			_image.data[index] = new_r;
-			_image.data[index+1] = new_g;
-			_image.data[index+2] = new_b;
-			_image.data[index+3] = alpha;
-		}
-	}
+	//rounded, same as the png decoder does it
+	yconv::pixels::premultiply(_image.data.data(), static_cast<size_t>(_image.width)*_image.height);
 }
 
 void texture::update_buffers() const
@@ -456,8 +490,24 @@ void texture::update_buffers() const
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexImage2D(GL_TEXTURE_2D, 0, _type, _image.width, _image.height, 0, _type, GL_UNSIGNED_BYTE, _image.data.data());
-	glGenerateMipmap(GL_TEXTURE_2D);
+
+	if(_mips.empty())
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, _type, _image.width, _image.height, 0, _type, GL_UNSIGNED_BYTE, _image.data.data());
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		return;
+	}
+
+	for(size_t level = 0; level < _mips.levels(); ++level)
+	{
+		glTexImage2D(GL_TEXTURE_2D, level, _type, _mips.width(level), _mips.height(level), 0, _type, GL_UNSIGNED_BYTE,
+			_mips.data(level));
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, _mips.levels()-1);
+	//a min filter without mipmap in its name never reads past level 0
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 }
 
 bool texture::parse_image(const std::string image_path, const std::string file_format)
@@ -475,6 +525,21 @@ bool texture::parse_image(const std::string image_path, const std::string file_f
 	return false;
 }
 
+void texture::parse_png(const std::string image_path)
+{
+	yconv::png::output_format format;
+	format.flip = true;
+	format.premultiply = true;
+
+	yconv::alpha_type alpha;
+	_image = yconv::png::read(image_path, format, alpha);
+
+	_type = calc_type(_image.bpp);
+
+	//same as contains_transparent, only rgba textures count as transparent
+	_has_transparency = _image.bpp==4 && alpha!=yconv::alpha_type::opaque;
+}
+
 bool texture::parse_default(const default_texture id)
 {
 	switch(id)
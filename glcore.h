@@ -232,8 +232,16 @@ namespace yangl
 			texture() {};
 			texture(const std::string image_path);
 			texture(const default_texture id);
-			texture(const yconv::image image);
-			texture(const int width, const int height, const std::vector<uint8_t> data);
+			texture(const yconv::image& image);
+			//takes the pixels over, a decoded image gets uploaded without being copied
+			texture(yconv::image&& image);
+			//copied once, flipped on the way
+			texture(const yconv::image_view image);
+			//uploads the levels as they are, so they should already be flipped and premultiplied
+			texture(const yconv::mip_chain& mips);
+			texture(yconv::mip_chain&& mips);
+			texture(const int width, const int height, const std::vector<uint8_t>& data);
+			texture(const int width, const int height, std::vector<uint8_t>&& data);
 
 			void set_current() const;
 			
@@ -243,17 +251,21 @@ namespace yangl
 			
 		private:
 			void full_setup() noexcept;
+			void mips_setup();
 
 			void premultiply() noexcept;
 			void update_buffers() const;
 
 			bool parse_image(const std::string image_path, const std::string file_format);
+			void parse_png(const std::string image_path);
 			bool parse_default(const default_texture id);
 
 			static unsigned calc_type(const uint8_t bpp);
 
 			unsigned _type;
 			yconv::image _image;
+			//precomputed levels, the image only keeps the size then, otherwise the driver makes them
+			yconv::mip_chain _mips;
 			
 			bool _empty = true;
 			bool _has_transparency = false;
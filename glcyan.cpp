@@ -202,10 +202,10 @@ font_data controller::create_font(const FT_Face font, const int size) noexcept
 		}
 	}
 
-	const yconv::image fonts_image(c_font.max_width*yconst::load_chars,
-		c_font.max_height, 1, fonts_atlas);
+	yconv::image fonts_image(c_font.max_width*yconst::load_chars,
+		c_font.max_height, 1, std::move(fonts_atlas));
 
-	return font_data{c_font.letters, core::texture(fonts_image), letter_models};
+	return font_data{c_font.letters, core::texture(std::move(fonts_image)), letter_models};
 }
 
 raw_font_data controller::load_raw_font(const FT_Face font, const int size) noexcept
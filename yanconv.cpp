@@ -1,15 +1,36 @@
 #include <cmath>
+#include <cassert>
 #include <cstring>
 #include <climits>
 #include <fstream>
+#include <sstream>
 #include <iostream>
 #include <algorithm>
 #include <chrono>
 #include <tuple>
 #include <filesystem>
 #include <array>
+#include <queue>
+#include <thread>
+#include <functional>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "yanconv.h"
+#include "ythreads.h"
 
 using namespace yconv;
 
@@ -31,6 +52,94 @@ std::vector<std::string> yconv::string_split(std::string text, const std::string
     return r_vec;
 }
 
+mapped_file::mapped_file(const std::filesystem::path path)
+{
+#ifdef _WIN32
+    const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if(file==INVALID_HANDLE_VALUE)
+        throw std::runtime_error("cant open file: " + path.string());
+
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file, &file_size))
+    {
+        CloseHandle(file);
+        throw std::runtime_error("cant get the size of file: " + path.string());
+    }
+
+    _size = file_size.QuadPart;
+
+    //empty files cant be mapped
+    if(_size!=0)
+    {
+        const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(mapping!=nullptr)
+        {
+            _data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            CloseHandle(mapping);
+        }
+    }
+
+    CloseHandle(file);
+
+    if(_size!=0 && _data==nullptr)
+        throw std::runtime_error("cant map file: " + path.string());
+#else
+    const int file = open(path.c_str(), O_RDONLY);
+    if(file==-1)
+        throw std::runtime_error("cant open file: " + path.string());
+
+    struct stat file_stat;
+    if(fstat(file, &file_stat)==-1)
+    {
+        close(file);
+        throw std::runtime_error("cant get the size of file: " + path.string());
+    }
+
+    _size = file_stat.st_size;
+
+    //empty files cant be mapped
+    if(_size!=0)
+    {
+        void* mapping = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+        if(mapping!=MAP_FAILED)
+        {
+            madvise(mapping, _size, MADV_SEQUENTIAL);
+            _data = static_cast<const uint8_t*>(mapping);
+        }
+    }
+
+    //the mapping stays valid without the descriptor
+    close(file);
+
+    if(_size!=0 && _data==nullptr)
+        throw std::runtime_error("cant map file: " + path.string());
+#endif
+}
+
+mapped_file::~mapped_file()
+{
+    if(_data==nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(_data);
+#else
+    munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+}
+
+const uint8_t* mapped_file::data() const noexcept
+{
+    return _data;
+}
+
+size_t mapped_file::size() const noexcept
+{
+    return _size;
+}
+
 image::image() : data({})
 {
 }
@@ -41,35 +150,87 @@ image::image(const std::filesystem::path image_path)
     	throw std::runtime_error("cant read texture: " + image_path.string());
 }
 
-image::image(const unsigned width, const unsigned height, const uint8_t bpp, const std::vector<uint8_t> data)
+image::image(const unsigned width, const unsigned height, const uint8_t bpp, const std::vector<uint8_t>& data)
 : width(width), height(height), bpp(bpp), data(data)
 {
 
 }
 
-void image::grayscale()
+image::image(const unsigned width, const unsigned height, const uint8_t bpp, std::vector<uint8_t>&& data) noexcept
+: width(width), height(height), bpp(bpp), data(std::move(data))
 {
-    if(bpp==1)
-        return;
 
-    std::vector<uint8_t> grayscale_image;
-    grayscale_image.reserve(width*height);
+}
 
-    for(unsigned y = 0; y<height; ++y)
+image::image(const image_view view)
+: width(view.width), height(view.height), bpp(view.bpp), data(static_cast<size_t>(view.height)*view.row_size())
+{
+    const size_t row_size = view.row_size();
+    if(view.contiguous())
     {
-        for(unsigned x = 0; x<width; ++x)
-        {
-            unsigned avg_pixel = 0;
-
-            for(uint8_t bppi = 0; bppi < bpp; ++bppi)
-            {
-                avg_pixel += data[y*width*bpp+x*bpp+bppi];
-            }
-            avg_pixel /= bpp;
-            grayscale_image.emplace_back(avg_pixel);
-        }
+        std::copy(view.data, view.data+data.size(), data.begin());
+        return;
     }
 
+    for(unsigned y = 0; y < height; ++y)
+        std::copy(view.row(y), view.row(y)+row_size, data.begin()+y*row_size);
+}
+
+image_view image::view() const noexcept
+{
+    return image_view(data.data(), width, height, bpp);
+}
+
+image_view::image_view(const uint8_t* data, const unsigned width, const unsigned height, const uint8_t bpp,
+    const std::ptrdiff_t stride) noexcept
+: data(data), width(width), height(height), bpp(bpp),
+stride(stride==0 ? static_cast<std::ptrdiff_t>(width)*bpp : stride)
+{
+}
+
+image_view::image_view(const image& img) noexcept
+: image_view(img.data.data(), img.width, img.height, img.bpp)
+{
+}
+
+const uint8_t* image_view::row(const unsigned y) const noexcept
+{
+    return data+static_cast<std::ptrdiff_t>(y)*stride;
+}
+
+size_t image_view::row_size() const noexcept
+{
+    return static_cast<size_t>(width)*bpp;
+}
+
+bool image_view::contiguous() const noexcept
+{
+    return stride==static_cast<std::ptrdiff_t>(row_size());
+}
+
+image_view image_view::crop(const unsigned x, const unsigned y, const unsigned width, const unsigned height) const noexcept
+{
+    assert(x+width<=this->width && y+height<=this->height);
+
+    return image_view(row(y)+static_cast<size_t>(x)*bpp, width, height, bpp, stride);
+}
+
+image_view image_view::flipped() const noexcept
+{
+    if(height==0)
+        return *this;
+
+    return image_view(row(height-1), width, height, bpp, -stride);
+}
+
+void image::grayscale()
+{
+    if(bpp==1)
+        return;
+
+    std::vector<uint8_t> grayscale_image(static_cast<size_t>(width)*height);
+    pixels::luminance(data.data(), bpp, grayscale_image.data(), grayscale_image.size());
+
     bpp = 1;
     data = std::move(grayscale_image);
 }
@@ -79,165 +240,46 @@ void image::bpp_resize(const uint8_t set_bpp, const uint8_t extra_channel)
     if(bpp==set_bpp)
         return;
 
-    std::vector<uint8_t> recolored_image;
-    recolored_image.reserve(width*height*set_bpp);
-
-    for(unsigned y = 0; y<height; ++y)
-    {
-        for(unsigned x = 0; x<width; ++x)
-        {
-            for(uint8_t bppi = 0; bppi<set_bpp; ++bppi)
-            {
-                if(bppi<bpp)
-                {
-                    recolored_image.emplace_back(data[y*width*bpp+x*bpp+bppi]);
-                } else
-                {
-                    recolored_image.emplace_back(extra_channel);
-                }
-            }
-        }
-    }
+    std::vector<uint8_t> recolored_image(static_cast<size_t>(width)*height*set_bpp);
+    pixels::copy_channels(data.data(), bpp, recolored_image.data(), set_bpp, static_cast<size_t>(width)*height,
+        extra_channel);
 
     bpp = set_bpp;
     data = std::move(recolored_image);
 }
 
-void image::resize(const unsigned set_width, const unsigned set_height, const resize_type type)
+void image::resize(const unsigned set_width, const unsigned set_height, const resize_type type,
+    const unsigned threads_num)
 {
     if(set_width==width&&set_height==height)
         return;
 
-    std::vector<uint8_t> resized_image;
-    resized_image.reserve(set_width*set_height*bpp);
-
-    const float resize_ratio_width = static_cast<float>(set_width)/width;
-    const float resize_ratio_height = static_cast<float>(set_height)/height;
+    if(type!=resize_type::nearest_neighbor)
+    {
+        const resample::weight_table columns = resample::weights(width, set_width, type);
+        const resample::weight_table rows = resample::weights(height, set_height, type);
 
-    const float c_pixel_width = 1/resize_ratio_width;
-    const float c_pixel_height = 1/resize_ratio_height;
-    const float c_pixel_width_half = c_pixel_width/2;
-    const float c_pixel_height_half = c_pixel_height/2;
+        *this = resample::resize(*this, columns, rows, threads_num);
+        return;
+    }
 
-    std::vector<uint8_t> res_pixel(bpp);
-    std::vector<unsigned> avg_pixel(bpp);
+    std::vector<uint8_t> resized_image;
+    resized_image.reserve(set_width*set_height*bpp);
 
     for(unsigned y = 0; y < set_height; ++y)
     {
         for(unsigned x = 0; x < set_width; ++x)
         {
-            switch(type)
-            {
-                case resize_type::nearest_neighbor:
-                {
-                    const float ratio_x = x/static_cast<float>(set_width);
-                    const float ratio_y = y/static_cast<float>(set_height);
-
-                    const float calc_x = std::round(width*ratio_x);
-                    const float calc_y = std::round(height*ratio_y);
-
-                    const unsigned pixel_start_index = calc_y*width*bpp+calc_x*bpp;
-                    for(uint8_t bppi = 0; bppi < bpp; ++bppi)
-                    {
-                        res_pixel[bppi] = data[pixel_start_index+bppi];
-                    }
-
-                    break;
-                }
-
-                case resize_type::area_sample:
-                {
-                    const float left_border = std::max(0.0f, (x/resize_ratio_width-c_pixel_width_half));
-                    const float top_border = std::max(0.0f, (y/resize_ratio_height-c_pixel_height_half));
-                    const float right_border = std::min(static_cast<float>(width), (x/resize_ratio_width+c_pixel_width_half));
-                    const float bottom_border = std::min(static_cast<float>(height), (y/resize_ratio_height+c_pixel_height_half));
-
-                    const unsigned lowest_x = static_cast<unsigned>(left_border);
-                    const unsigned lowest_y = static_cast<unsigned>(top_border);
-                    const unsigned highest_x = std::ceil(right_border);
-                    const unsigned highest_y = std::ceil(bottom_border);
-
-                    float pixels_avgd = 0;
-
-                    for(unsigned oy = lowest_y; oy < highest_y; ++oy)
-                    {
-                        for(unsigned ox = lowest_x; ox < highest_x; ++ox)
-                        {
-                            float pixel_inside_area_ratio;
-
-                            if(oy!=lowest_y&&ox!=lowest_x&&oy!=(highest_y-1)&&ox!=(highest_x-1))
-                            {
-                                //pixel fully inside the area
-                                pixel_inside_area_ratio = 1;
-                            } else
-                            {
-                                //pixel partially outside the area
-
-                                const float scaled_x = x/resize_ratio_width;
-                                const float scaled_y = y/resize_ratio_height;
-
-                                float overlap_width;
-                                float overlap_height;
-
-                                if(ox!=lowest_x&&ox!=(highest_x-1))
-                                {
-                                    if(scaled_x<=ox)
-                                    {
-                                        overlap_width = scaled_x+c_pixel_width_half-ox;
-                                        overlap_width = overlap_width>1?1:overlap_width;
-                                    } else
-                                    {
-                                        overlap_width = scaled_x-(ox+1);
-                                        overlap_width = overlap_width>1?1:overlap_width;
-                                    }
-                                } else
-                                {
-                                    //this is just for a speedup
-                                    overlap_width = 1;
-                                }
-
-                                if(ox!=lowest_x&&ox!=(highest_x-1))
-                                {
-                                    if(scaled_y<=oy)
-                                    {
-                                        overlap_height = scaled_y+c_pixel_height_half-oy;
-                                        overlap_height = overlap_height>1?1:overlap_height;
-                                    } else
-                                    {
-                                        overlap_height = scaled_y-(oy+1);
-                                        overlap_height = overlap_height>1?1:overlap_height;
-                                    }
-                                } else
-                                {
-                                    //this is just for a speedup
-                                    overlap_height = 1;
-                                }
-
-                                pixel_inside_area_ratio = overlap_width*overlap_height;
-                            }
-
-                            pixels_avgd += pixel_inside_area_ratio;
-
-                            for(uint8_t bppi = 0; bppi < bpp; ++bppi)
-                            {
-                                avg_pixel[bppi] += data[oy*width*bpp+ox*bpp+bppi]*pixel_inside_area_ratio;
-                            }
-                        }
-                    }
-
-                    for(uint8_t bppi = 0; bppi < bpp; ++bppi)
-                    {
-                        res_pixel[bppi] = avg_pixel[bppi]/pixels_avgd;
-                        avg_pixel[bppi] = 0;
-                    }
+            const float ratio_x = x/static_cast<float>(set_width);
+            const float ratio_y = y/static_cast<float>(set_height);
 
-                    break;
-                }
-            }
+            const float calc_x = std::round(width*ratio_x);
+            const float calc_y = std::round(height*ratio_y);
 
+            const unsigned pixel_start_index = calc_y*width*bpp+calc_x*bpp;
             for(uint8_t bppi = 0; bppi < bpp; ++bppi)
             {
-                resized_image.emplace_back(res_pixel[bppi]);
+                resized_image.emplace_back(data[pixel_start_index+bppi]);
             }
         }
     }
@@ -248,176 +290,1749 @@ void image::resize(const unsigned set_width, const unsigned set_height, const re
     data = std::move(resized_image);
 }
 
-void image::flip()
+resample::weight_table resample::weights(const unsigned source_size, const unsigned size,
+    const image::resize_type type)
 {
-    std::vector<uint8_t> flipped_data;
-    flipped_data.reserve(data.size());
-
-    for(unsigned y = height; y>0; --y)
+    switch(type)
     {
-        for(unsigned x = 0; x<width; ++x)
-        {
-            for(uint8_t bppi = 0; bppi<bpp; ++bppi)
-            {
-                flipped_data.emplace_back(data[(y-1)*width*bpp+x*bpp+bppi]);
-            }
-        }
-    }
+        case image::resize_type::bilinear:
+            return kernel_weights(source_size, size, 1, bilinear_kernel);
+        case image::resize_type::catmull_rom:
+            return kernel_weights(source_size, size, 2, catmull_rom_kernel);
+        case image::resize_type::mitchell:
+            return kernel_weights(source_size, size, 2, mitchell_kernel);
+        case image::resize_type::lanczos:
+            return kernel_weights(source_size, size, 3, lanczos_kernel);
+
+        case image::resize_type::area_sample:
+            return area_weights(source_size, size);
 
-    data = std::move(flipped_data);
+        default:
+            throw std::runtime_error("resample::weights nearest neighbor has no weights");
+    }
 }
 
-bool image::save(const std::filesystem::path save_path) const
+resample::weight_table resample::area_weights(const unsigned source_size, const unsigned size)
 {
-    if(save_path.extension()==".pgm")
-    {
-        pgm::save(*this, save_path);
+    const double scale = static_cast<double>(source_size)/size;
 
-        return true;
-    } else if(save_path.extension()==".ppm")
-    {
-    	ppm::save(*this, save_path);
-    	
-    	return true;
-    } else if(save_path.extension()==".png")
+    std::vector<unsigned> starts(size);
+    std::vector<std::vector<double>> weights(size);
+
+    for(unsigned i = 0; i < size; ++i)
     {
-    	png::save(*this, save_path);
-    	
-    	return true;
+        //the span of the output pixel in source pixels
+        const double begin = i*scale;
+        const double end = std::min(static_cast<double>(source_size), (i+1)*scale);
+
+        const unsigned first = std::min(static_cast<unsigned>(begin), source_size-1);
+        const unsigned last = std::max(first+1, std::min(source_size, static_cast<unsigned>(std::ceil(end))));
+
+        starts[i] = first;
+        for(unsigned s = first; s < last; ++s)
+            weights[i].push_back(std::max(0.0, std::min(end, s+1.0)-std::max(begin, static_cast<double>(s))));
     }
 
-    return false;
+    return fixed_weights(source_size, starts, weights);
 }
 
-bool image::read(const std::filesystem::path load_path)
+resample::weight_table resample::kernel_weights(const unsigned source_size, const unsigned size,
+    const double support, double (*kernel)(const double))
 {
-    if(load_path.extension()==".png")
-    {
-        *this = png::read(load_path);
-        return true;
-    } else if(load_path.extension()==".pgm")
+    const double scale = static_cast<double>(source_size)/size;
+
+    //stretched over more source pixels when shrinking, otherwise it would skip some
+    const double kernel_scale = std::max(1.0, scale);
+    const double reach = support*kernel_scale;
+
+    std::vector<unsigned> starts(size);
+    std::vector<std::vector<double>> weights(size);
+
+    for(unsigned i = 0; i < size; ++i)
     {
-        *this = pgm::read(load_path);
-        return true;
+        //in source pixels, centers are halfway into a pixel
+        const double center = (i+0.5)*scale;
+
+        const unsigned first = std::min(source_size-1, static_cast<unsigned>(std::max(0.0, std::floor(center-reach))));
+        const unsigned last = std::max(first+1, std::min(source_size, static_cast<unsigned>(std::ceil(center+reach))));
+
+        starts[i] = first;
+        for(unsigned s = first; s < last; ++s)
+            weights[i].push_back(kernel((s+0.5-center)/kernel_scale));
     }
-    
-    return false;
-}
 
-unsigned image::pixel_color_pos(const unsigned x, const unsigned y, const uint8_t color) const noexcept
-{
-	return y*width*bpp+x*bpp+color;
+    return fixed_weights(source_size, starts, weights);
 }
 
-uint8_t image::pixel_color(const unsigned x, const unsigned y, const uint8_t color) const noexcept
+double resample::bilinear_kernel(const double x) noexcept
 {
-	return data[y*width*bpp+x*bpp+color];
+    return std::max(0.0, 1-std::abs(x));
 }
 
-bool image::contains_transparent() const noexcept
+double resample::cubic_kernel(const double x, const double b, const double c) noexcept
 {
-    if(bpp!=4)
-        return false;
+    const double distance = std::abs(x);
 
-    unsigned index = 0;
-    for(int y = 0; y < height; ++y)
+    if(distance<1)
     {
-        for(int x = 0; x < width; ++x, index += bpp)
-        {
-            if(data[index+(bpp-1)]!=255)
-                return true;
-        }
+        return ((12-9*b-6*c)*distance*distance*distance+(-18+12*b+6*c)*distance*distance+(6-2*b))/6;
+    } else if(distance<2)
+    {
+        return ((-b-6*c)*distance*distance*distance+(6*b+30*c)*distance*distance+(-12*b-48*c)*distance+(8*b+24*c))/6;
     }
 
-    return false;
+    return 0;
 }
 
-bool image::can_parse(const std::string extension) noexcept
+double resample::catmull_rom_kernel(const double x) noexcept
 {
-    if(extension=="png" || extension==".png")
-    {
-        return true;
-    } else if(extension=="pgm" || extension==".pgm")
-    {
-        return true;
-    }
-    return false;
+    return cubic_kernel(x, 0, 0.5);
 }
 
-model::model(const std::filesystem::path model_path)
+double resample::mitchell_kernel(const double x) noexcept
 {
-    if(!read(model_path))
-        throw std::runtime_error("cant read model: " + model_path.string());
+    return cubic_kernel(x, 1.0/3, 1.0/3);
 }
 
-bool model::read(const std::filesystem::path load_path)
+double resample::lanczos_kernel(const double x) noexcept
 {
-    if(load_path.extension()==".obj")
-    {
-        obj_read(load_path);
-        return true;
-    }
+    constexpr double lobes = 3;
+    if(std::abs(x)>=lobes)
+        return 0;
 
-    return false;
+    if(x==0)
+        return 1;
+
+    const double pi_x = M_PI*x;
+    return lobes*std::sin(pi_x)*std::sin(pi_x/lobes)/(pi_x*pi_x);
 }
 
-bool model::obj_read(const std::filesystem::path load_path)
+resample::weight_table resample::fixed_weights(const unsigned source_size, const std::vector<unsigned>& starts,
+    const std::vector<std::vector<double>>& weights)
 {
-    std::ifstream model_stream(load_path);
-    std::string c_model_line;
-
-    vertices.clear();
-    indices.clear();
+    weight_table table;
+    table.starts = starts;
 
-    std::vector<float> c_verts;
-    std::vector<int> vert_indices;
-    std::vector<float> c_uvs;
-    std::vector<int> uv_indices;
+    for(const std::vector<double>& pixel_weights : weights)
+        table.taps = std::max(table.taps, static_cast<unsigned>(pixel_weights.size()));
 
-    std::vector<float> c_normals;
-    std::vector<int> normal_indices;
-
-    std::vector<std::string> saved_params;
-    std::vector<int> repeated_verts;
+    table.weights.assign(weights.size()*table.taps, 0);
 
-    while(std::getline(model_stream, c_model_line))
+    const int one = 1<<weight_bits;
+    for(size_t i = 0; i < weights.size(); ++i)
     {
-        if(c_model_line.find("#")!=-1)
-            c_model_line = c_model_line.substr(0, c_model_line.find("#"));
+        double total = 0;
+        for(const double weight : weights[i])
+            total += weight;
 
-        if(c_model_line.length()==0)
-            continue;
+        //near the end the pixels that would read past it get zero weight in front instead
+        const unsigned shift = std::min(table.starts[i], table.starts[i]+table.taps>source_size
+            ? table.starts[i]+table.taps-source_size : 0);
+        table.starts[i] -= shift;
 
-        if(c_model_line.find("vt")==0)
+        int16_t* fixed = table.weights.data()+i*table.taps+shift;
+
+        int fixed_total = 0;
+        size_t largest = 0;
+        for(size_t w = 0; w < weights[i].size(); ++w)
         {
-            std::stringstream texuv_stream(c_model_line.substr(3));
+            fixed[w] = total==0 ? 0 : std::lround(weights[i][w]/total*one);
+            fixed_total += fixed[w];
 
-            float x, y;
+            if(std::abs(fixed[w])>std::abs(fixed[largest]))
+                largest = w;
+        }
 
-            texuv_stream >> x >> y;
+        //whatever rounding lost goes to the biggest weight so flat colors stay the same
+        if(!weights[i].empty())
+            fixed[largest] += one-fixed_total;
+    }
 
-            c_uvs.reserve(3);
-            c_uvs.push_back(x);
-            c_uvs.push_back(y);
-        } else if(c_model_line.find("vn")==0)
-        {
-            std::stringstream normal_stream(c_model_line.substr(3));
+    return table;
+}
 
-            float x, y, z;
+namespace
+{
+    typedef ythreads::pool<void(*)(resample::resample_job*), resample::resample_job*> resample_pool;
 
-            normal_stream >> x >> y >> z;
+    //splits a pass into a few bands per thread so uneven ones even out, without a pool it runs right here
+    void run_bands(resample_pool* workers_pool, const unsigned workers, const resample::resample_job& pass)
+    {
+        const unsigned rows_num = pass.end_row-pass.first_row;
+        const unsigned bands_num = workers_pool ? std::min(rows_num, workers*4) : 1;
 
-            c_normals.reserve(3);
-            c_normals.push_back(x);
-            c_normals.push_back(y);
-            c_normals.push_back(z);
-        } else if(c_model_line.find("v")==0)
+        std::vector<resample::resample_job> bands(bands_num);
+        std::vector<std::future<void>> finished(bands_num);
+        for(unsigned b = 0; b < bands_num; ++b)
         {
-            std::stringstream vertex_stream(c_model_line.substr(2));
-
-            float x, y, z;
+            resample::resample_job& band = bands[b];
+            band.in = pass.in;
+            band.out = pass.out;
+            band.wide = pass.wide;
+            band.in_width = pass.in_width;
+            band.out_width = pass.out_width;
+            band.channels = pass.channels;
+            band.in_stride = pass.in_stride;
+            band.table = pass.table;
+            band.row_pass = pass.row_pass;
+            band.first_row = pass.first_row+static_cast<uint64_t>(rows_num)*b/bands_num;
+            band.end_row = pass.first_row+static_cast<uint64_t>(rows_num)*(b+1)/bands_num;
+
+            finished[b] = band.done.get_future();
+
+            if(workers_pool)
+            {
+                workers_pool->run(&band);
+            } else
+            {
+                resample::resample_band(&band);
+            }
+        }
 
-            vertex_stream >> x >> y >> z;
+        for(std::future<void>& band_finished : finished)
+            band_finished.wait();
+    }
+}
+
+yconv::image resample::resize(const image_view& img, const weight_table& columns, const weight_table& rows,
+    const unsigned threads_num)
+{
+    const unsigned out_width = columns.starts.size();
+    const unsigned out_height = rows.starts.size();
+
+    image resized(out_width, out_height, img.bpp, {});
+    if(out_width==0 || out_height==0)
+        return resized;
+
+    const bool resize_rows = out_width!=img.width || columns.taps!=1;
+    const bool resize_columns = out_height!=img.height || rows.taps!=1;
+
+    std::vector<uint8_t> row_resized;
+    if(resize_rows)
+        row_resized.resize(static_cast<size_t>(out_width)*img.height*img.bpp);
+
+    if(resize_columns)
+        resized.data.resize(static_cast<size_t>(out_width)*out_height*img.bpp);
+
+    //rows first, then each output row only reads the resized rows its taps need
+    resample_job row_job;
+    row_job.in = img.data;
+    row_job.out = row_resized.data();
+    row_job.in_width = img.width;
+    row_job.out_width = out_width;
+    row_job.channels = img.bpp;
+    row_job.in_stride = img.stride;
+    row_job.table = &columns;
+    row_job.row_pass = true;
+    row_job.first_row = 0;
+    row_job.end_row = img.height;
+
+    resample_job column_job;
+    column_job.in = resize_rows ? row_resized.data() : img.data;
+    column_job.out = resized.data.data();
+    column_job.in_width = out_width;
+    column_job.out_width = out_width;
+    column_job.channels = img.bpp;
+    column_job.in_stride = resize_rows ? static_cast<std::ptrdiff_t>(out_width)*img.bpp : img.stride;
+    column_job.table = &rows;
+    column_job.row_pass = false;
+    column_job.first_row = 0;
+    column_job.end_row = out_height;
+
+    const unsigned workers = threads_num==0 ? std::thread::hardware_concurrency() : threads_num;
+
+    std::unique_ptr<resample_pool> workers_pool;
+    if(workers>1)
+        workers_pool = std::make_unique<resample_pool>(workers, resample_band);
+
+    if(resize_rows)
+        run_bands(workers_pool.get(), workers, row_job);
+
+    if(resize_columns)
+        run_bands(workers_pool.get(), workers, column_job);
+
+    if(!resize_columns)
+        resized = resize_rows ? image(out_width, out_height, img.bpp, std::move(row_resized)) : image(img);
+
+    return resized;
+}
+
+void resample::resample_band(resample_job* job) noexcept
+{
+    //in values, bytes or 15 bit
+    const size_t in_row_size = static_cast<size_t>(job->in_width)*job->channels;
+    const size_t out_row_size = static_cast<size_t>(job->out_width)*job->channels;
+
+    if(job->wide)
+    {
+        const uint16_t* in = static_cast<const uint16_t*>(job->in);
+        uint16_t* out = static_cast<uint16_t*>(job->out);
+
+        if(job->row_pass)
+        {
+            row_pass_wide(in+job->first_row*in_row_size, job->in_width, out+job->first_row*out_row_size,
+                job->out_width, job->end_row-job->first_row, job->channels, *job->table);
+        } else
+        {
+            column_pass_wide(in, out, out_row_size, job->first_row, job->end_row, *job->table);
+        }
+    } else
+    {
+        const uint8_t* in = static_cast<const uint8_t*>(job->in);
+        uint8_t* out = static_cast<uint8_t*>(job->out);
+
+        if(job->row_pass)
+        {
+            row_pass(in+job->first_row*job->in_stride, job->in_stride, out+job->first_row*out_row_size,
+                job->out_width, job->end_row-job->first_row, job->channels, *job->table);
+        } else
+        {
+            column_pass(in, job->in_stride, out, out_row_size, job->first_row, job->end_row, *job->table);
+        }
+    }
+
+    job->done.set_value();
+}
+
+void resample::row_pass(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out, const unsigned out_width,
+    const unsigned rows_num, const uint8_t channels, const weight_table& table) noexcept
+{
+    switch(channels)
+    {
+        case 1:
+            row_pass_scalar<1>(in, in_stride, out, out_width, rows_num, table);
+            break;
+        case 2:
+            row_pass_scalar<2>(in, in_stride, out, out_width, rows_num, table);
+            break;
+        case 3:
+            row_pass_scalar<3>(in, in_stride, out, out_width, rows_num, table);
+            break;
+        default:
+            //a whole pixel fits in a vector lane for each channel
+            row_pass_sse2(in, in_stride, out, out_width, rows_num, table);
+            break;
+    }
+}
+
+namespace
+{
+    //rounded and clamped back from fixed point
+    inline uint8_t from_fixed(const int value) noexcept
+    {
+        const int rounded = (value+(1<<(resample::weight_bits-1)))>>resample::weight_bits;
+        return std::clamp(rounded, 0, 255);
+    }
+}
+
+template<int channels>
+void resample::row_pass_scalar(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out,
+    const unsigned out_width, const unsigned rows_num, const weight_table& table) noexcept
+{
+    for(unsigned y = 0; y < rows_num; ++y)
+    {
+        const uint8_t* in_row = in+static_cast<std::ptrdiff_t>(y)*in_stride;
+        uint8_t* out_row = out+static_cast<size_t>(y)*out_width*channels;
+
+        for(unsigned x = 0; x < out_width; ++x)
+        {
+            const uint8_t* source = in_row+table.starts[x]*channels;
+            const int16_t* weights = table.weights.data()+x*table.taps;
+
+            std::array<int, channels> sums{};
+            for(unsigned t = 0; t < table.taps; ++t)
+            {
+                for(int c = 0; c < channels; ++c)
+                    sums[c] += source[t*channels+c]*weights[t];
+            }
+
+            for(int c = 0; c < channels; ++c)
+                out_row[x*channels+c] = from_fixed(sums[c]);
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+void resample::row_pass_sse2(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out, const unsigned out_width,
+    const unsigned rows_num, const weight_table& table) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi32(1<<(weight_bits-1));
+
+    for(unsigned y = 0; y < rows_num; ++y)
+    {
+        const uint8_t* in_row = in+static_cast<std::ptrdiff_t>(y)*in_stride;
+        uint8_t* out_row = out+static_cast<size_t>(y)*out_width*4;
+
+        for(unsigned x = 0; x < out_width; ++x)
+        {
+            const uint8_t* source = in_row+table.starts[x]*4;
+            const int16_t* weights = table.weights.data()+x*table.taps;
+
+            //a lane for each channel, two source pixels at a time interleaved for madd
+            __m128i sums = rounding;
+
+            unsigned t = 0;
+            for(; t+1 < table.taps; t += 2)
+            {
+                __m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source+t*4)), zero);
+                pixels = _mm_unpacklo_epi16(pixels, _mm_srli_si128(pixels, 8));
+
+                const __m128i pair = _mm_set1_epi32(static_cast<uint16_t>(weights[t])
+                    |static_cast<uint32_t>(static_cast<uint16_t>(weights[t+1]))<<16);
+
+                sums = _mm_add_epi32(sums, _mm_madd_epi16(pixels, pair));
+            }
+
+            if(t<table.taps)
+            {
+                int32_t last_pixel;
+                std::memcpy(&last_pixel, source+t*4, 4);
+
+                __m128i pixels = _mm_unpacklo_epi8(_mm_cvtsi32_si128(last_pixel), zero);
+                pixels = _mm_unpacklo_epi16(pixels, zero);
+
+                sums = _mm_add_epi32(sums, _mm_madd_epi16(pixels, _mm_set1_epi32(static_cast<uint16_t>(weights[t]))));
+            }
+
+            sums = _mm_srai_epi32(sums, weight_bits);
+            sums = _mm_packs_epi32(sums, sums);
+            sums = _mm_packus_epi16(sums, sums);
+
+            const int32_t pixel = _mm_cvtsi128_si32(sums);
+            std::memcpy(out_row+x*4, &pixel, 4);
+        }
+    }
+}
+#else
+void resample::row_pass_sse2(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out, const unsigned out_width,
+    const unsigned rows_num, const weight_table& table) noexcept
+{
+    row_pass_scalar<4>(in, in_stride, out, out_width, rows_num, table);
+}
+#endif
+
+void resample::column_pass(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out, const size_t row_size,
+    const unsigned first_row, const unsigned end_row, const weight_table& table) noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    column_pass_sse2(in, in_stride, out, row_size, first_row, end_row, table);
+#else
+    column_pass_scalar(in, in_stride, out, row_size, first_row, end_row, table);
+#endif
+}
+
+void resample::column_pass_scalar(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out,
+    const size_t row_size, const unsigned first_row, const unsigned end_row, const weight_table& table) noexcept
+{
+    for(unsigned y = first_row; y < end_row; ++y)
+    {
+        const uint8_t* source = in+table.starts[y]*in_stride;
+        const int16_t* weights = table.weights.data()+y*table.taps;
+
+        uint8_t* out_row = out+y*row_size;
+        for(size_t i = 0; i < row_size; ++i)
+        {
+            int sum = 0;
+            for(unsigned t = 0; t < table.taps; ++t)
+                sum += source[t*in_stride+i]*weights[t];
+
+            out_row[i] = from_fixed(sum);
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+void resample::column_pass_sse2(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out,
+    const size_t row_size, const unsigned first_row, const unsigned end_row, const weight_table& table) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi32(1<<(weight_bits-1));
+
+    for(unsigned y = first_row; y < end_row; ++y)
+    {
+        const uint8_t* source = in+table.starts[y]*in_stride;
+        const int16_t* weights = table.weights.data()+y*table.taps;
+
+        uint8_t* out_row = out+y*row_size;
+
+        //the same byte of two rows interleaved so madd does both taps at once, 8 bytes of the row at a time
+        size_t i = 0;
+        for(; i+8 <= row_size; i += 8)
+        {
+            __m128i sums_low = rounding;
+            __m128i sums_high = rounding;
+
+            for(unsigned t = 0; t < table.taps; t += 2)
+            {
+                const __m128i first = _mm_unpacklo_epi8(
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source+t*in_stride+i)), zero);
+
+                //past the last tap the second row is zeros
+                const bool paired = t+1<table.taps;
+                const __m128i second = paired ? _mm_unpacklo_epi8(
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source+(t+1)*in_stride+i)), zero) : zero;
+
+                const __m128i pair = _mm_set1_epi32(static_cast<uint16_t>(weights[t])
+                    |(paired ? static_cast<uint32_t>(static_cast<uint16_t>(weights[t+1]))<<16 : 0));
+
+                sums_low = _mm_add_epi32(sums_low, _mm_madd_epi16(_mm_unpacklo_epi16(first, second), pair));
+                sums_high = _mm_add_epi32(sums_high, _mm_madd_epi16(_mm_unpackhi_epi16(first, second), pair));
+            }
+
+            sums_low = _mm_srai_epi32(sums_low, weight_bits);
+            sums_high = _mm_srai_epi32(sums_high, weight_bits);
+
+            const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(sums_low, sums_high), zero);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out_row+i), packed);
+        }
+
+        for(; i < row_size; ++i)
+        {
+            int sum = 0;
+            for(unsigned t = 0; t < table.taps; ++t)
+                sum += source[t*in_stride+i]*weights[t];
+
+            out_row[i] = from_fixed(sum);
+        }
+    }
+}
+#else
+void resample::column_pass_sse2(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out,
+    const size_t row_size, const unsigned first_row, const unsigned end_row, const weight_table& table) noexcept
+{
+    column_pass_scalar(in, in_stride, out, row_size, first_row, end_row, table);
+}
+#endif
+
+void resample::row_pass_wide(const uint16_t* in, const unsigned in_width, uint16_t* out, const unsigned out_width,
+    const unsigned rows_num, const uint8_t channels, const weight_table& table) noexcept
+{
+    switch(channels)
+    {
+        case 1:
+            row_pass_wide_scalar<1>(in, in_width, out, out_width, rows_num, table);
+            break;
+        case 2:
+            row_pass_wide_scalar<2>(in, in_width, out, out_width, rows_num, table);
+            break;
+        case 3:
+            row_pass_wide_scalar<3>(in, in_width, out, out_width, rows_num, table);
+            break;
+        default:
+            row_pass_wide_sse2(in, in_width, out, out_width, rows_num, table);
+            break;
+    }
+}
+
+namespace
+{
+    inline uint16_t from_fixed_wide(const int value) noexcept
+    {
+        const int rounded = (value+(1<<(resample::weight_bits-1)))>>resample::weight_bits;
+        return std::clamp(rounded, 0, resample::wide_max);
+    }
+}
+
+template<int channels>
+void resample::row_pass_wide_scalar(const uint16_t* in, const unsigned in_width, uint16_t* out,
+    const unsigned out_width, const unsigned rows_num, const weight_table& table) noexcept
+{
+    for(unsigned y = 0; y < rows_num; ++y)
+    {
+        const uint16_t* in_row = in+static_cast<size_t>(y)*in_width*channels;
+        uint16_t* out_row = out+static_cast<size_t>(y)*out_width*channels;
+
+        for(unsigned x = 0; x < out_width; ++x)
+        {
+            const uint16_t* source = in_row+table.starts[x]*channels;
+            const int16_t* weights = table.weights.data()+x*table.taps;
+
+            std::array<int, channels> sums{};
+            for(unsigned t = 0; t < table.taps; ++t)
+            {
+                for(int c = 0; c < channels; ++c)
+                    sums[c] += source[t*channels+c]*weights[t];
+            }
+
+            for(int c = 0; c < channels; ++c)
+                out_row[x*channels+c] = from_fixed_wide(sums[c]);
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+void resample::row_pass_wide_sse2(const uint16_t* in, const unsigned in_width, uint16_t* out,
+    const unsigned out_width, const unsigned rows_num, const weight_table& table) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi32(1<<(weight_bits-1));
+
+    for(unsigned y = 0; y < rows_num; ++y)
+    {
+        const uint16_t* in_row = in+static_cast<size_t>(y)*in_width*4;
+        uint16_t* out_row = out+static_cast<size_t>(y)*out_width*4;
+
+        for(unsigned x = 0; x < out_width; ++x)
+        {
+            const uint16_t* source = in_row+table.starts[x]*4;
+            const int16_t* weights = table.weights.data()+x*table.taps;
+
+            //same as the byte version, 15 bits still fit madd as signed values
+            __m128i sums = rounding;
+
+            unsigned t = 0;
+            for(; t+1 < table.taps; t += 2)
+            {
+                __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source+t*4));
+                pixels = _mm_unpacklo_epi16(pixels, _mm_srli_si128(pixels, 8));
+
+                const __m128i pair = _mm_set1_epi32(static_cast<uint16_t>(weights[t])
+                    |static_cast<uint32_t>(static_cast<uint16_t>(weights[t+1]))<<16);
+
+                sums = _mm_add_epi32(sums, _mm_madd_epi16(pixels, pair));
+            }
+
+            if(t<table.taps)
+            {
+                const __m128i pixels = _mm_unpacklo_epi16(
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source+t*4)), zero);
+
+                sums = _mm_add_epi32(sums, _mm_madd_epi16(pixels, _mm_set1_epi32(static_cast<uint16_t>(weights[t]))));
+            }
+
+            sums = _mm_srai_epi32(sums, weight_bits);
+            sums = _mm_max_epi16(_mm_packs_epi32(sums, sums), zero);
+
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out_row+x*4), sums);
+        }
+    }
+}
+#else
+void resample::row_pass_wide_sse2(const uint16_t* in, const unsigned in_width, uint16_t* out,
+    const unsigned out_width, const unsigned rows_num, const weight_table& table) noexcept
+{
+    row_pass_wide_scalar<4>(in, in_width, out, out_width, rows_num, table);
+}
+#endif
+
+void resample::column_pass_wide(const uint16_t* in, uint16_t* out, const size_t row_size, const unsigned first_row,
+    const unsigned end_row, const weight_table& table) noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    column_pass_wide_sse2(in, out, row_size, first_row, end_row, table);
+#else
+    column_pass_wide_scalar(in, out, row_size, first_row, end_row, table);
+#endif
+}
+
+void resample::column_pass_wide_scalar(const uint16_t* in, uint16_t* out, const size_t row_size,
+    const unsigned first_row, const unsigned end_row, const weight_table& table) noexcept
+{
+    for(unsigned y = first_row; y < end_row; ++y)
+    {
+        const uint16_t* source = in+table.starts[y]*row_size;
+        const int16_t* weights = table.weights.data()+y*table.taps;
+
+        uint16_t* out_row = out+y*row_size;
+        for(size_t i = 0; i < row_size; ++i)
+        {
+            int sum = 0;
+            for(unsigned t = 0; t < table.taps; ++t)
+                sum += source[t*row_size+i]*weights[t];
+
+            out_row[i] = from_fixed_wide(sum);
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+void resample::column_pass_wide_sse2(const uint16_t* in, uint16_t* out, const size_t row_size,
+    const unsigned first_row, const unsigned end_row, const weight_table& table) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi32(1<<(weight_bits-1));
+
+    for(unsigned y = first_row; y < end_row; ++y)
+    {
+        const uint16_t* source = in+table.starts[y]*row_size;
+        const int16_t* weights = table.weights.data()+y*table.taps;
+
+        uint16_t* out_row = out+y*row_size;
+
+        size_t i = 0;
+        for(; i+8 <= row_size; i += 8)
+        {
+            __m128i sums_low = rounding;
+            __m128i sums_high = rounding;
+
+            for(unsigned t = 0; t < table.taps; t += 2)
+            {
+                const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source+t*row_size+i));
+
+                const bool paired = t+1<table.taps;
+                const __m128i second = paired
+                    ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(source+(t+1)*row_size+i)) : zero;
+
+                const __m128i pair = _mm_set1_epi32(static_cast<uint16_t>(weights[t])
+                    |(paired ? static_cast<uint32_t>(static_cast<uint16_t>(weights[t+1]))<<16 : 0));
+
+                sums_low = _mm_add_epi32(sums_low, _mm_madd_epi16(_mm_unpacklo_epi16(first, second), pair));
+                sums_high = _mm_add_epi32(sums_high, _mm_madd_epi16(_mm_unpackhi_epi16(first, second), pair));
+            }
+
+            sums_low = _mm_srai_epi32(sums_low, weight_bits);
+            sums_high = _mm_srai_epi32(sums_high, weight_bits);
+
+            const __m128i packed = _mm_max_epi16(_mm_packs_epi32(sums_low, sums_high), zero);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out_row+i), packed);
+        }
+
+        for(; i < row_size; ++i)
+        {
+            int sum = 0;
+            for(unsigned t = 0; t < table.taps; ++t)
+                sum += source[t*row_size+i]*weights[t];
+
+            out_row[i] = from_fixed_wide(sum);
+        }
+    }
+}
+#else
+void resample::column_pass_wide_sse2(const uint16_t* in, uint16_t* out, const size_t row_size,
+    const unsigned first_row, const unsigned end_row, const weight_table& table) noexcept
+{
+    column_pass_wide_scalar(in, out, row_size, first_row, end_row, table);
+}
+#endif
+
+double resample::kaiser_kernel(const double x) noexcept
+{
+    constexpr double lobes = 3;
+    //how fast the window falls off, higher rings less but blurs more
+    constexpr double alpha = 4;
+
+    if(std::abs(x)>=lobes)
+        return 0;
+
+    const double sinc = x==0 ? 1 : std::sin(M_PI*x)/(M_PI*x);
+
+    const double ratio = x/lobes;
+    return sinc*bessel_i0(alpha*std::sqrt(1-ratio*ratio))/bessel_i0(alpha);
+}
+
+double resample::bessel_i0(const double x) noexcept
+{
+    //sum of ((x/2)^k/k!)^2, converges fast for the small values the window uses
+    double sum = 1;
+    double term = 1;
+    for(int k = 1; k < 32 && term>sum*1e-12; ++k)
+    {
+        term *= (x/(2*k))*(x/(2*k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+namespace
+{
+    //srgb byte to 15 bit linear light
+    const std::array<uint16_t, 256>& srgb_to_linear() noexcept
+    {
+        static const std::array<uint16_t, 256> table = []()
+        {
+            std::array<uint16_t, 256> values;
+            for(int i = 0; i < 256; ++i)
+            {
+                const double color = i/255.0;
+                const double linear = color<=0.04045 ? color/12.92 : std::pow((color+0.055)/1.055, 2.4);
+
+                values[i] = std::lround(linear*resample::wide_max);
+            }
+
+            return values;
+        }();
+
+        return table;
+    }
+
+    //15 bit linear light back to a rounded srgb byte
+    const std::vector<uint8_t>& linear_to_srgb() noexcept
+    {
+        static const std::vector<uint8_t> table = []()
+        {
+            std::vector<uint8_t> values(resample::wide_max+1);
+            for(int i = 0; i <= resample::wide_max; ++i)
+            {
+                const double linear = static_cast<double>(i)/resample::wide_max;
+                const double color = linear<=0.0031308 ? linear*12.92 : 1.055*std::pow(linear, 1/2.4)-0.055;
+
+                values[i] = std::lround(color*255);
+            }
+
+            return values;
+        }();
+
+        return table;
+    }
+
+    //same as the srgb ones but straight, for alpha and images that arent srgb
+    const std::array<uint16_t, 256>& byte_to_wide() noexcept
+    {
+        static const std::array<uint16_t, 256> table = []()
+        {
+            std::array<uint16_t, 256> values;
+            for(int i = 0; i < 256; ++i)
+                values[i] = (i*resample::wide_max+127)/255;
+
+            return values;
+        }();
+
+        return table;
+    }
+
+    const std::vector<uint8_t>& wide_to_byte() noexcept
+    {
+        static const std::vector<uint8_t> table = []()
+        {
+            std::vector<uint8_t> values(resample::wide_max+1);
+            for(int i = 0; i <= resample::wide_max; ++i)
+                values[i] = (i*255+resample::wide_max/2)/resample::wide_max;
+
+            return values;
+        }();
+
+        return table;
+    }
+
+    //only the channels that arent alpha
+    inline bool color_channel(const uint8_t channel, const uint8_t bpp) noexcept
+    {
+        return !((bpp==2 || bpp==4) && channel==bpp-1);
+    }
+}
+
+mip_chain image::mipmaps(const mip_filter filter, const bool srgb, const unsigned threads_num) const
+{
+    return mip_chain(*this, filter, srgb, threads_num);
+}
+
+mip_chain::mip_chain(const image_view& img, const mip_filter filter, const bool srgb, const unsigned threads_num)
+: _bpp(img.bpp)
+{
+    if(img.width==0 || img.height==0)
+        return;
+
+    //every level is laid out first so theres only one allocation
+    size_t total_size = 0;
+    for(unsigned width = img.width, height = img.height;; width = std::max(1u, width/2), height = std::max(1u, height/2))
+    {
+        _levels.push_back({width, height, total_size});
+        total_size += static_cast<size_t>(width)*height*_bpp;
+
+        if(width==1 && height==1)
+            break;
+    }
+
+    _data.resize(total_size);
+
+    const size_t row_size = img.row_size();
+    for(unsigned y = 0; y < img.height; ++y)
+        std::copy(img.row(y), img.row(y)+row_size, _data.begin()+y*row_size);
+
+    if(_levels.size()==1)
+        return;
+
+    //a table for each channel both ways
+    std::array<const uint16_t*, 4> to_wide;
+    std::array<const uint8_t*, 4> to_byte;
+    for(uint8_t c = 0; c < _bpp; ++c)
+    {
+        const bool linear_light = srgb && color_channel(c, _bpp);
+        to_wide[c] = linear_light ? srgb_to_linear().data() : byte_to_wide().data();
+        to_byte[c] = linear_light ? linear_to_srgb().data() : wide_to_byte().data();
+    }
+
+    //each level is filtered from the one before it in 15 bits, so the rounding doesnt pile up
+    std::vector<uint16_t> current(size(0));
+    for(size_t i = 0; i < current.size(); i += _bpp)
+    {
+        for(uint8_t c = 0; c < _bpp; ++c)
+            current[i+c] = to_wide[c][_data[i+c]];
+    }
+
+    std::vector<uint16_t> row_resized;
+    std::vector<uint16_t> next;
+
+    const unsigned workers = threads_num==0 ? std::thread::hardware_concurrency() : threads_num;
+
+    std::unique_ptr<resample_pool> workers_pool;
+    if(workers>1)
+        workers_pool = std::make_unique<resample_pool>(workers, resample::resample_band);
+
+    const auto level_weights = [filter](const unsigned source_size, const unsigned size)
+    {
+        if(filter==mip_filter::kaiser)
+            return resample::kernel_weights(source_size, size, 3, resample::kaiser_kernel);
+
+        return resample::area_weights(source_size, size);
+    };
+
+    for(size_t level = 1; level < _levels.size(); ++level)
+    {
+        const unsigned in_width = _levels[level-1].width;
+        const unsigned in_height = _levels[level-1].height;
+
+        const unsigned out_width = _levels[level].width;
+        const unsigned out_height = _levels[level].height;
+
+        const resample::weight_table columns = level_weights(in_width, out_width);
+        const resample::weight_table rows = level_weights(in_height, out_height);
+
+        //once a side is 1 pixel it stays that way and only the other side gets filtered
+        const uint16_t* columns_source = current.data();
+        if(out_width!=in_width)
+        {
+            row_resized.resize(static_cast<size_t>(out_width)*in_height*_bpp);
+
+            resample::resample_job row_job;
+            row_job.in = current.data();
+            row_job.out = row_resized.data();
+            row_job.wide = true;
+            row_job.in_width = in_width;
+            row_job.out_width = out_width;
+            row_job.channels = _bpp;
+            row_job.table = &columns;
+            row_job.row_pass = true;
+            row_job.first_row = 0;
+            row_job.end_row = in_height;
+
+            run_bands(workers_pool.get(), workers, row_job);
+
+            columns_source = row_resized.data();
+        }
+
+        next.resize(static_cast<size_t>(out_width)*out_height*_bpp);
+        if(out_height!=in_height)
+        {
+            resample::resample_job column_job;
+            column_job.in = columns_source;
+            column_job.out = next.data();
+            column_job.wide = true;
+            column_job.in_width = out_width;
+            column_job.out_width = out_width;
+            column_job.channels = _bpp;
+            column_job.table = &rows;
+            column_job.row_pass = false;
+            column_job.first_row = 0;
+            column_job.end_row = out_height;
+
+            run_bands(workers_pool.get(), workers, column_job);
+        } else
+        {
+            std::copy(columns_source, columns_source+next.size(), next.begin());
+        }
+
+        uint8_t* out = _data.data()+_levels[level].offset;
+        for(size_t i = 0; i < next.size(); i += _bpp)
+        {
+            for(uint8_t c = 0; c < _bpp; ++c)
+                out[i+c] = to_byte[c][next[i+c]];
+        }
+
+        std::swap(current, next);
+    }
+}
+
+size_t mip_chain::levels() const noexcept
+{
+    return _levels.size();
+}
+
+unsigned mip_chain::width(const size_t level) const noexcept
+{
+    return _levels[level].width;
+}
+
+unsigned mip_chain::height(const size_t level) const noexcept
+{
+    return _levels[level].height;
+}
+
+uint8_t mip_chain::bpp() const noexcept
+{
+    return _bpp;
+}
+
+const uint8_t* mip_chain::data(const size_t level) const noexcept
+{
+    return _data.data()+_levels[level].offset;
+}
+
+size_t mip_chain::size(const size_t level) const noexcept
+{
+    return static_cast<size_t>(_levels[level].width)*_levels[level].height*_bpp;
+}
+
+yconv::image mip_chain::level(const size_t level) const
+{
+    return image(width(level), height(level), _bpp, std::vector<uint8_t>(data(level), data(level)+size(level)));
+}
+
+bool mip_chain::empty() const noexcept
+{
+    return _levels.empty();
+}
+
+void image::flip() noexcept
+{
+    const size_t row_size = static_cast<size_t>(width)*bpp;
+    for(unsigned y = 0; y < height/2; ++y)
+    {
+        const auto top = data.begin()+y*row_size;
+        std::swap_ranges(top, top+row_size, data.begin()+(height-1-y)*row_size);
+    }
+}
+
+bool image::save(const std::filesystem::path save_path) const
+{
+    if(save_path.extension()==".pgm")
+    {
+        pgm::save(*this, save_path);
+
+        return true;
+    } else if(save_path.extension()==".ppm")
+    {
+    	ppm::save(*this, save_path);
+    	
+    	return true;
+    } else if(save_path.extension()==".png")
+    {
+    	png::save(*this, save_path);
+    	
+    	return true;
+    }
+
+    return false;
+}
+
+bool image::read(const std::filesystem::path load_path)
+{
+    if(load_path.extension()==".png")
+    {
+        *this = png::read(load_path);
+        return true;
+    } else if(load_path.extension()==".pgm")
+    {
+        *this = pgm::read(load_path);
+        return true;
+    }
+    
+    return false;
+}
+
+bool image::probe(const std::filesystem::path load_path, image_info& info)
+{
+    if(load_path.extension()==".png")
+    {
+        info = png::probe(load_path);
+        return true;
+    } else if(load_path.extension()==".pgm")
+    {
+        info = pgm::probe(load_path);
+        return true;
+    }
+
+    return false;
+}
+
+unsigned image::pixel_color_pos(const unsigned x, const unsigned y, const uint8_t color) const noexcept
+{
+	return y*width*bpp+x*bpp+color;
+}
+
+uint8_t image::pixel_color(const unsigned x, const unsigned y, const uint8_t color) const noexcept
+{
+	return data[y*width*bpp+x*bpp+color];
+}
+
+bool image::contains_transparent() const noexcept
+{
+    if(bpp!=4)
+        return false;
+
+    return pixels::has_transparency(data.data(), bpp, static_cast<size_t>(width)*height);
+}
+
+namespace
+{
+    //rounded color*alpha/255 without a division
+    inline uint8_t multiply_alpha(const uint8_t color, const uint8_t alpha) noexcept
+    {
+        const unsigned value = color*alpha+128;
+        return (value+(value>>8))>>8;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+namespace
+{
+    //byte shuffles over as many whole pixels as fit in 16 bytes on both sides
+    //outside of pixels since gcc drops the target from a template defined apart from its declaration
+    template<int in_channels, int out_channels>
+    __attribute__((target("ssse3")))
+    void copy_channels_ssse3(const uint8_t* in, uint8_t* out, const size_t count, const uint8_t fill) noexcept
+    {
+        //pixels per shuffle, and shuffles per load when the output is wider so one load feeds several stores
+        constexpr int step = 16/std::max(in_channels, out_channels);
+        constexpr int stores = 16/in_channels/step;
+
+        //whole pixels the loads and the stores reach into, the stores past the last step pixels included
+        constexpr int reach = std::max((16+in_channels-1)/in_channels, (stores-1)*step+(16+out_channels-1)/out_channels);
+
+        //-1 zeroes the new channels so fill can be or'd in
+        alignas(16) int8_t spread[stores][16];
+        alignas(16) uint8_t fills[16];
+        for(int i = 0; i < 16; ++i)
+        {
+            const int pixel = i/out_channels;
+            const int channel = i%out_channels;
+
+            for(int store = 0; store < stores; ++store)
+            {
+                spread[store][i] = pixel<step && channel<in_channels
+                    ? (store*step+pixel)*in_channels+channel : -1;
+            }
+
+            fills[i] = pixel<step && channel>=in_channels ? fill : 0;
+        }
+
+        __m128i shuffles[stores];
+        for(int store = 0; store < stores; ++store)
+            shuffles[store] = _mm_load_si128(reinterpret_cast<const __m128i*>(spread[store]));
+
+        const __m128i filled = _mm_load_si128(reinterpret_cast<const __m128i*>(fills));
+
+        //whatever gets stored past the step pixels is written over by the next store
+        size_t i = 0;
+        for(; i+reach <= count; i += stores*step)
+        {
+            const __m128i colors = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in+i*in_channels));
+
+            for(int store = 0; store < stores; ++store)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out+(i+store*step)*out_channels),
+                    _mm_or_si128(_mm_shuffle_epi8(colors, shuffles[store]), filled));
+            }
+        }
+
+        pixels::copy_channels_scalar<in_channels, out_channels>(in+i*in_channels, out+i*out_channels, count-i, fill);
+    }
+}
+#endif
+
+void pixels::copy_channels(const uint8_t* in, const uint8_t in_channels, uint8_t* out, const uint8_t out_channels,
+    const size_t count, const uint8_t fill) noexcept
+{
+    if(count==0)
+        return;
+
+    if(in_channels==out_channels)
+    {
+        std::memcpy(out, in, count*in_channels);
+        return;
+    }
+
+    typedef void (*copy_func)(const uint8_t*, uint8_t*, const size_t, const uint8_t);
+    typedef copy_func copy_table[4][4];
+
+    static constexpr copy_table scalar_copiers{
+        {copy_channels_scalar<1, 1>, copy_channels_scalar<1, 2>, copy_channels_scalar<1, 3>, copy_channels_scalar<1, 4>},
+        {copy_channels_scalar<2, 1>, copy_channels_scalar<2, 2>, copy_channels_scalar<2, 3>, copy_channels_scalar<2, 4>},
+        {copy_channels_scalar<3, 1>, copy_channels_scalar<3, 2>, copy_channels_scalar<3, 3>, copy_channels_scalar<3, 4>},
+        {copy_channels_scalar<4, 1>, copy_channels_scalar<4, 2>, copy_channels_scalar<4, 3>, copy_channels_scalar<4, 4>}};
+
+#if defined(__x86_64__) || defined(__i386__)
+    static constexpr copy_table ssse3_copiers{
+        {copy_channels_ssse3<1, 1>, copy_channels_ssse3<1, 2>, copy_channels_ssse3<1, 3>, copy_channels_ssse3<1, 4>},
+        {copy_channels_ssse3<2, 1>, copy_channels_ssse3<2, 2>, copy_channels_ssse3<2, 3>, copy_channels_ssse3<2, 4>},
+        {copy_channels_ssse3<3, 1>, copy_channels_ssse3<3, 2>, copy_channels_ssse3<3, 3>, copy_channels_ssse3<3, 4>},
+        {copy_channels_ssse3<4, 1>, copy_channels_ssse3<4, 2>, copy_channels_ssse3<4, 3>, copy_channels_ssse3<4, 4>}};
+
+    static const copy_table& copiers = __builtin_cpu_supports("ssse3") ? ssse3_copiers : scalar_copiers;
+#else
+    static const copy_table& copiers = scalar_copiers;
+#endif
+
+    copiers[in_channels-1][out_channels-1](in, out, count, fill);
+}
+
+template<int in_channels, int out_channels>
+void pixels::copy_channels_scalar(const uint8_t* in, uint8_t* out, const size_t count, const uint8_t fill) noexcept
+{
+    for(size_t i = 0; i < count; ++i, in += in_channels, out += out_channels)
+    {
+        for(int c = 0; c < out_channels; ++c)
+            out[c] = c<in_channels ? in[c] : fill;
+    }
+}
+
+void pixels::luminance(const uint8_t* in, const uint8_t channels, uint8_t* out, const size_t count) noexcept
+{
+    //an empty image has no pixels to point at
+    if(count==0)
+        return;
+
+    switch(channels)
+    {
+        case 1:
+            std::memcpy(out, in, count);
+            break;
+        case 2:
+            luminance_scalar<2>(in, out, count);
+            break;
+        case 3:
+            luminance_scalar<3>(in, out, count);
+            break;
+        default:
+        {
+            typedef void (*luminance_func)(const uint8_t*, uint8_t*, const size_t);
+
+#if defined(__x86_64__) || defined(__i386__)
+            static const luminance_func best_luminance = __builtin_cpu_supports("avx2") ? luminance_avx2
+                : luminance_sse2;
+#else
+            static const luminance_func best_luminance = luminance_scalar<4>;
+#endif
+
+            best_luminance(in, out, count);
+            break;
+        }
+    }
+}
+
+namespace
+{
+    //rec 601 weights out of 256
+    constexpr int luma_red = 77;
+    constexpr int luma_green = 150;
+    constexpr int luma_blue = 29;
+}
+
+template<int channels>
+void pixels::luminance_scalar(const uint8_t* in, uint8_t* out, const size_t count) noexcept
+{
+    for(size_t i = 0; i < count; ++i, in += channels)
+    {
+        if constexpr(channels<3)
+        {
+            out[i] = in[0];
+        } else
+        {
+            out[i] = (in[0]*luma_red+in[1]*luma_green+in[2]*luma_blue+128)>>8;
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+namespace
+{
+    //the sums of 4 rgba pixels as 32 bit lanes, rounded but not shifted yet
+    inline __m128i luma_sums(const __m128i pixels, const __m128i weights, const __m128i zero) noexcept
+    {
+        //r*77+g*150 and b*29 for each pixel, then the two added together
+        const __m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights);
+        const __m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights);
+
+        const __m128i low_sums = _mm_add_epi32(low, _mm_srli_si128(low, 4));
+        const __m128i high_sums = _mm_add_epi32(high, _mm_srli_si128(high, 4));
+
+        //lanes 0 and 2 of each hold the pixels
+        const __m128i sums = _mm_unpacklo_epi64(_mm_shuffle_epi32(low_sums, _MM_SHUFFLE(3, 3, 2, 0)),
+            _mm_shuffle_epi32(high_sums, _MM_SHUFFLE(3, 3, 2, 0)));
+
+        return _mm_srli_epi32(_mm_add_epi32(sums, _mm_set1_epi32(128)), 8);
+    }
+}
+
+void pixels::luminance_sse2(const uint8_t* in, uint8_t* out, const size_t count) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weights = _mm_setr_epi16(luma_red, luma_green, luma_blue, 0, luma_red, luma_green, luma_blue, 0);
+
+    size_t i = 0;
+    for(; i+16 <= count; i += 16)
+    {
+        const __m128i* pixels = reinterpret_cast<const __m128i*>(in+i*4);
+
+        const __m128i first = _mm_packs_epi32(luma_sums(_mm_loadu_si128(pixels), weights, zero),
+            luma_sums(_mm_loadu_si128(pixels+1), weights, zero));
+        const __m128i second = _mm_packs_epi32(luma_sums(_mm_loadu_si128(pixels+2), weights, zero),
+            luma_sums(_mm_loadu_si128(pixels+3), weights, zero));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i), _mm_packus_epi16(first, second));
+    }
+
+    luminance_scalar<4>(in+i*4, out+i, count-i);
+}
+
+__attribute__((target("avx2")))
+void pixels::luminance_avx2(const uint8_t* in, uint8_t* out, const size_t count) noexcept
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i weights = _mm256_setr_epi16(luma_red, luma_green, luma_blue, 0, luma_red, luma_green, luma_blue, 0,
+        luma_red, luma_green, luma_blue, 0, luma_red, luma_green, luma_blue, 0);
+    const __m256i rounding = _mm256_set1_epi32(128);
+
+    //8 pixels, in order
+    const auto sums = [&](const uint8_t* pixels) __attribute__((target("avx2")))
+    {
+        const __m256i colors = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels));
+
+        const __m256i low = _mm256_madd_epi16(_mm256_unpacklo_epi8(colors, zero), weights);
+        const __m256i high = _mm256_madd_epi16(_mm256_unpackhi_epi8(colors, zero), weights);
+
+        const __m256i low_sums = _mm256_add_epi32(low, _mm256_srli_si256(low, 4));
+        const __m256i high_sums = _mm256_add_epi32(high, _mm256_srli_si256(high, 4));
+
+        const __m256i ordered = _mm256_unpacklo_epi64(_mm256_shuffle_epi32(low_sums, _MM_SHUFFLE(3, 3, 2, 0)),
+            _mm256_shuffle_epi32(high_sums, _MM_SHUFFLE(3, 3, 2, 0)));
+
+        return _mm256_srli_epi32(_mm256_add_epi32(ordered, rounding), 8);
+    };
+
+    size_t i = 0;
+    for(; i+16 <= count; i += 16)
+    {
+        //packing works inside each half, the permutes put the pixels back in order
+        __m256i words = _mm256_packs_epi32(sums(in+i*4), sums(in+i*4+32));
+        words = _mm256_permute4x64_epi64(words, _MM_SHUFFLE(3, 1, 2, 0));
+
+        __m256i bytes = _mm256_packus_epi16(words, words);
+        bytes = _mm256_permute4x64_epi64(bytes, _MM_SHUFFLE(3, 1, 2, 0));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i), _mm256_castsi256_si128(bytes));
+    }
+
+    luminance_sse2(in+i*4, out+i, count-i);
+}
+#else
+void pixels::luminance_sse2(const uint8_t* in, uint8_t* out, const size_t count) noexcept
+{
+    luminance_scalar<4>(in, out, count);
+}
+
+void pixels::luminance_avx2(const uint8_t* in, uint8_t* out, const size_t count) noexcept
+{
+    luminance_scalar<4>(in, out, count);
+}
+#endif
+
+void pixels::premultiply(uint8_t* data, const size_t count) noexcept
+{
+    typedef void (*premultiply_func)(uint8_t*, const size_t);
+
+#if defined(__x86_64__) || defined(__i386__)
+    static const premultiply_func best_premultiply = __builtin_cpu_supports("avx2") ? premultiply_avx2
+        : premultiply_sse2;
+#else
+    static const premultiply_func best_premultiply = premultiply_scalar;
+#endif
+
+    best_premultiply(data, count);
+}
+
+void pixels::premultiply_scalar(uint8_t* data, const size_t count) noexcept
+{
+    for(size_t i = 0; i < count; ++i, data += 4)
+    {
+        const uint8_t alpha = data[3];
+        for(int c = 0; c < 3; ++c)
+            data[c] = multiply_alpha(data[c], alpha);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+namespace
+{
+    //same as multiply_alpha on 16 bit lanes, t = c*a+128 then (t+(t>>8))>>8
+    inline __m128i multiply_alpha_sse2(const __m128i colors) noexcept
+    {
+        __m128i alpha = _mm_shufflelo_epi16(colors, _MM_SHUFFLE(3, 3, 3, 3));
+        alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+
+        const __m128i value = _mm_add_epi16(_mm_mullo_epi16(colors, alpha), _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 8);
+    }
+}
+
+void pixels::premultiply_sse2(uint8_t* data, const size_t count) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+
+    size_t i = 0;
+    for(; i+4 <= count; i += 4)
+    {
+        __m128i* pixels = reinterpret_cast<__m128i*>(data+i*4);
+        const __m128i colors = _mm_loadu_si128(pixels);
+
+        const __m128i multiplied = _mm_packus_epi16(multiply_alpha_sse2(_mm_unpacklo_epi8(colors, zero)),
+            multiply_alpha_sse2(_mm_unpackhi_epi8(colors, zero)));
+
+        //alpha itself stays as it was
+        _mm_storeu_si128(pixels, _mm_or_si128(_mm_andnot_si128(alpha_mask, multiplied),
+            _mm_and_si128(alpha_mask, colors)));
+    }
+
+    premultiply_scalar(data+i*4, count-i);
+}
+
+__attribute__((target("avx2")))
+void pixels::premultiply_avx2(uint8_t* data, const size_t count) noexcept
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha_mask = _mm256_set1_epi32(0xff000000);
+    const __m256i rounding = _mm256_set1_epi16(128);
+
+    const auto multiply = [&](const __m256i colors) __attribute__((target("avx2")))
+    {
+        __m256i alpha = _mm256_shufflelo_epi16(colors, _MM_SHUFFLE(3, 3, 3, 3));
+        alpha = _mm256_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+
+        const __m256i value = _mm256_add_epi16(_mm256_mullo_epi16(colors, alpha), rounding);
+        return _mm256_srli_epi16(_mm256_add_epi16(value, _mm256_srli_epi16(value, 8)), 8);
+    };
+
+    size_t i = 0;
+    for(; i+8 <= count; i += 8)
+    {
+        __m256i* pixels = reinterpret_cast<__m256i*>(data+i*4);
+        const __m256i colors = _mm256_loadu_si256(pixels);
+
+        //unpacking and packing both stay inside each half so the order holds
+        const __m256i multiplied = _mm256_packus_epi16(multiply(_mm256_unpacklo_epi8(colors, zero)),
+            multiply(_mm256_unpackhi_epi8(colors, zero)));
+
+        _mm256_storeu_si256(pixels, _mm256_or_si256(_mm256_andnot_si256(alpha_mask, multiplied),
+            _mm256_and_si256(alpha_mask, colors)));
+    }
+
+    premultiply_sse2(data+i*4, count-i);
+}
+#else
+void pixels::premultiply_sse2(uint8_t* data, const size_t count) noexcept
+{
+    premultiply_scalar(data, count);
+}
+
+void pixels::premultiply_avx2(uint8_t* data, const size_t count) noexcept
+{
+    premultiply_scalar(data, count);
+}
+#endif
+
+void pixels::unpremultiply(uint8_t* data, const size_t count) noexcept
+{
+    typedef void (*unpremultiply_func)(uint8_t*, const size_t);
+
+#if defined(__x86_64__) || defined(__i386__)
+    static const unpremultiply_func best_unpremultiply = __builtin_cpu_supports("avx2") ? unpremultiply_avx2
+        : unpremultiply_sse2;
+#else
+    static const unpremultiply_func best_unpremultiply = unpremultiply_scalar;
+#endif
+
+    best_unpremultiply(data, count);
+}
+
+void pixels::unpremultiply_scalar(uint8_t* data, const size_t count) noexcept
+{
+    //every color for every alpha, color*255/alpha rounded
+    static const std::vector<uint8_t> table = []()
+    {
+        std::vector<uint8_t> values(256*256, 0);
+        for(int alpha = 1; alpha < 256; ++alpha)
+        {
+            for(int color = 0; color < 256; ++color)
+                values[alpha*256+color] = std::min(255, (color*255+alpha/2)/alpha);
+        }
+
+        return values;
+    }();
+
+    for(size_t i = 0; i < count; ++i, data += 4)
+    {
+        const uint8_t* colors = table.data()+data[3]*256;
+        data[0] = colors[data[0]];
+        data[1] = colors[data[1]];
+        data[2] = colors[data[2]];
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+namespace
+{
+    //(color*255+alpha/2)/alpha truncated, for one pixel as 32 bit lanes
+    //a rounded float quotient can only land on the wrong side of a whole number above 256, where it gets clamped
+    //a 0 alpha gives inf or nan, which converts to the lowest int and packs to 0 like the table has
+    inline __m128i divide_alpha_sse2(const __m128i pixel) noexcept
+    {
+        const __m128i alpha = _mm_shuffle_epi32(pixel, _MM_SHUFFLE(3, 3, 3, 3));
+        const __m128i scaled = _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(pixel, 8), pixel), _mm_srli_epi32(alpha, 1));
+
+        return _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(scaled), _mm_cvtepi32_ps(alpha)));
+    }
+}
+
+void pixels::unpremultiply_sse2(uint8_t* data, const size_t count) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+
+    size_t i = 0;
+    for(; i+4 <= count; i += 4)
+    {
+        __m128i* pixels = reinterpret_cast<__m128i*>(data+i*4);
+        const __m128i colors = _mm_loadu_si128(pixels);
+
+        const __m128i low = _mm_unpacklo_epi8(colors, zero);
+        const __m128i high = _mm_unpackhi_epi8(colors, zero);
+
+        //saturating packs do the clamp to 255
+        const __m128i divided = _mm_packus_epi16(
+            _mm_packs_epi32(divide_alpha_sse2(_mm_unpacklo_epi16(low, zero)),
+                divide_alpha_sse2(_mm_unpackhi_epi16(low, zero))),
+            _mm_packs_epi32(divide_alpha_sse2(_mm_unpacklo_epi16(high, zero)),
+                divide_alpha_sse2(_mm_unpackhi_epi16(high, zero))));
+
+        _mm_storeu_si128(pixels, _mm_or_si128(_mm_andnot_si128(alpha_mask, divided),
+            _mm_and_si128(alpha_mask, colors)));
+    }
+
+    unpremultiply_scalar(data+i*4, count-i);
+}
+
+__attribute__((target("avx2")))
+void pixels::unpremultiply_avx2(uint8_t* data, const size_t count) noexcept
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha_mask = _mm256_set1_epi32(0xff000000);
+
+    //same as divide_alpha_sse2 for a pixel in each half
+    const auto divide = [&](const __m256i pixels) __attribute__((target("avx2")))
+    {
+        const __m256i alpha = _mm256_shuffle_epi32(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+        const __m256i scaled = _mm256_add_epi32(_mm256_sub_epi32(_mm256_slli_epi32(pixels, 8), pixels),
+            _mm256_srli_epi32(alpha, 1));
+
+        return _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(scaled), _mm256_cvtepi32_ps(alpha)));
+    };
+
+    size_t i = 0;
+    for(; i+8 <= count; i += 8)
+    {
+        __m256i* pixels = reinterpret_cast<__m256i*>(data+i*4);
+        const __m256i colors = _mm256_loadu_si256(pixels);
+
+        //unpacking and packing both stay inside each half so the order holds
+        const __m256i low = _mm256_unpacklo_epi8(colors, zero);
+        const __m256i high = _mm256_unpackhi_epi8(colors, zero);
+
+        const __m256i divided = _mm256_packus_epi16(
+            _mm256_packs_epi32(divide(_mm256_unpacklo_epi16(low, zero)), divide(_mm256_unpackhi_epi16(low, zero))),
+            _mm256_packs_epi32(divide(_mm256_unpacklo_epi16(high, zero)), divide(_mm256_unpackhi_epi16(high, zero))));
+
+        _mm256_storeu_si256(pixels, _mm256_or_si256(_mm256_andnot_si256(alpha_mask, divided),
+            _mm256_and_si256(alpha_mask, colors)));
+    }
+
+    unpremultiply_sse2(data+i*4, count-i);
+}
+#else
+void pixels::unpremultiply_sse2(uint8_t* data, const size_t count) noexcept
+{
+    unpremultiply_scalar(data, count);
+}
+
+void pixels::unpremultiply_avx2(uint8_t* data, const size_t count) noexcept
+{
+    unpremultiply_scalar(data, count);
+}
+#endif
+
+bool pixels::has_transparency(const uint8_t* data, const uint8_t channels, const size_t count) noexcept
+{
+    typedef bool (*transparency_func)(const uint8_t*, const uint8_t, const size_t);
+
+#if defined(__x86_64__) || defined(__i386__)
+    static const transparency_func best_transparency = __builtin_cpu_supports("avx2") ? has_transparency_avx2
+        : has_transparency_sse2;
+#else
+    static const transparency_func best_transparency = has_transparency_scalar;
+#endif
+
+    return best_transparency(data, channels, count);
+}
+
+bool pixels::has_transparency_scalar(const uint8_t* data, const uint8_t channels, const size_t count) noexcept
+{
+    for(size_t i = channels-1; i < count*channels; i += channels)
+    {
+        if(data[i]!=255)
+            return true;
+    }
+
+    return false;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+bool pixels::has_transparency_sse2(const uint8_t* data, const uint8_t channels, const size_t count) noexcept
+{
+    //colors get set so only the alpha bytes can fail the compare
+    const __m128i colors_mask = channels==4 ? _mm_set1_epi32(0x00ffffff) : _mm_set1_epi16(0x00ff);
+    const __m128i opaque = _mm_set1_epi8(-1);
+
+    //64 bytes and'ed together per check, it exits early without testing every load
+    const size_t size = count*channels;
+
+    size_t i = 0;
+    for(; i+64 <= size; i += 64)
+    {
+        const __m128i* pixels = reinterpret_cast<const __m128i*>(data+i);
+
+        const __m128i alphas = _mm_and_si128(_mm_and_si128(_mm_loadu_si128(pixels), _mm_loadu_si128(pixels+1)),
+            _mm_and_si128(_mm_loadu_si128(pixels+2), _mm_loadu_si128(pixels+3)));
+
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_or_si128(alphas, colors_mask), opaque))!=0xffff)
+            return true;
+    }
+
+    return has_transparency_scalar(data+i, channels, (size-i)/channels);
+}
+
+__attribute__((target("avx2")))
+bool pixels::has_transparency_avx2(const uint8_t* data, const uint8_t channels, const size_t count) noexcept
+{
+    const __m256i colors_mask = channels==4 ? _mm256_set1_epi32(0x00ffffff) : _mm256_set1_epi16(0x00ff);
+    const __m256i opaque = _mm256_set1_epi8(-1);
+
+    const size_t size = count*channels;
+
+    size_t i = 0;
+    for(; i+128 <= size; i += 128)
+    {
+        const __m256i* pixels = reinterpret_cast<const __m256i*>(data+i);
+
+        const __m256i alphas = _mm256_and_si256(
+            _mm256_and_si256(_mm256_loadu_si256(pixels), _mm256_loadu_si256(pixels+1)),
+            _mm256_and_si256(_mm256_loadu_si256(pixels+2), _mm256_loadu_si256(pixels+3)));
+
+        if(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_or_si256(alphas, colors_mask), opaque))!=-1)
+            return true;
+    }
+
+    return has_transparency_sse2(data+i, channels, (size-i)/channels);
+}
+#else
+bool pixels::has_transparency_sse2(const uint8_t* data, const uint8_t channels, const size_t count) noexcept
+{
+    return has_transparency_scalar(data, channels, count);
+}
+
+bool pixels::has_transparency_avx2(const uint8_t* data, const uint8_t channels, const size_t count) noexcept
+{
+    return has_transparency_scalar(data, channels, count);
+}
+#endif
+
+bool image::can_parse(const std::string extension) noexcept
+{
+    if(extension=="png" || extension==".png")
+    {
+        return true;
+    } else if(extension=="pgm" || extension==".pgm")
+    {
+        return true;
+    }
+    return false;
+}
+
+model::model(const std::filesystem::path model_path)
+{
+    if(!read(model_path))
+        throw std::runtime_error("cant read model: " + model_path.string());
+}
+
+bool model::read(const std::filesystem::path load_path)
+{
+    if(load_path.extension()==".obj")
+    {
+        obj_read(load_path);
+        return true;
+    }
+
+    return false;
+}
+
+bool model::obj_read(const std::filesystem::path load_path)
+{
+    std::ifstream model_stream(load_path);
+    std::string c_model_line;
+
+    vertices.clear();
+    indices.clear();
+
+    std::vector<float> c_verts;
+    std::vector<int> vert_indices;
+    std::vector<float> c_uvs;
+    std::vector<int> uv_indices;
+
+    std::vector<float> c_normals;
+    std::vector<int> normal_indices;
+
+    std::vector<std::string> saved_params;
+    std::vector<int> repeated_verts;
+
+    while(std::getline(model_stream, c_model_line))
+    {
+        if(c_model_line.find("#")!=-1)
+            c_model_line = c_model_line.substr(0, c_model_line.find("#"));
+
+        if(c_model_line.length()==0)
+            continue;
+
+        if(c_model_line.find("vt")==0)
+        {
+            std::stringstream texuv_stream(c_model_line.substr(3));
+
+            float x, y;
+
+            texuv_stream >> x >> y;
+
+            c_uvs.reserve(3);
+            c_uvs.push_back(x);
+            c_uvs.push_back(y);
+        } else if(c_model_line.find("vn")==0)
+        {
+            std::stringstream normal_stream(c_model_line.substr(3));
+
+            float x, y, z;
+
+            normal_stream >> x >> y >> z;
+
+            c_normals.reserve(3);
+            c_normals.push_back(x);
+            c_normals.push_back(y);
+            c_normals.push_back(z);
+        } else if(c_model_line.find("v")==0)
+        {
+            std::stringstream vertex_stream(c_model_line.substr(2));
+
+            float x, y, z;
+
+            vertex_stream >> x >> y >> z;
 
             c_verts.reserve(3);
             c_verts.push_back(x);
@@ -425,1370 +2040,4709 @@ bool model::obj_read(const std::filesystem::path load_path)
             c_verts.push_back(z);
         } else if(c_model_line.find("f")==0)
         {
-            std::vector<std::string> params = string_split(c_model_line.substr(2), " ");
+            std::vector<std::string> params = string_split(c_model_line.substr(2), " ");
+
+            const int params_size = params.size();
+
+            if(params[params_size-1].length()==0)
+            {
+                params.pop_back();
+            }
+
+            std::vector<int> order = {0, 1, 2};
+
+            if(params_size>3)
+            {
+                for(int i = 3; i < params_size; i++)
+                {
+                    order.push_back(0);
+                    order.push_back(i-1);
+                    order.push_back(i);
+                }
+            }
+
+            for(const auto& p : order)
+            {
+                const auto find_index = std::find(saved_params.begin(), saved_params.end(), params[p]);
+
+                if(find_index!=saved_params.end())
+                {
+                    repeated_verts.push_back(vert_indices.size()-std::distance(saved_params.begin(), find_index));
+                } else
+                {
+                    repeated_verts.push_back(0);
+                }
+
+                saved_params.push_back(params[p]);
+
+                const std::vector<std::string> face_vals = string_split(params[p], "/");
+
+                vert_indices.push_back(std::stoi(face_vals[0])-1);
+
+                if(face_vals.size()>=2 && face_vals[1].length()!=0)
+                {
+                    uv_indices.push_back(std::stoi(face_vals[1])-1);
+                } else
+                {
+                    uv_indices.push_back(UINT_MAX);
+                }
+
+                if(face_vals.size()==3)
+                {
+                    normal_indices.push_back(std::stoi(face_vals[2])-1);
+                } else
+                {
+                    normal_indices.push_back(UINT_MAX);
+                }
+            }
+        } else
+        {
+            //std::cout << c_model_line << std::endl;
+        }
+    }
+
+    int indexing_offset = 0;
+
+    for(int v = 0; v < vert_indices.size(); v++)
+    {
+        if(repeated_verts[v]==0)
+        {
+            vertices.push_back(c_verts[vert_indices[v]*3]);
+            vertices.push_back(c_verts[vert_indices[v]*3+1]);
+            vertices.push_back(c_verts[vert_indices[v]*3+2]);
+
+            indices.push_back(v-indexing_offset);
+
+            if(uv_indices[v]!=UINT_MAX)
+            {
+                vertices.push_back(c_uvs[uv_indices[v]*2]);
+                vertices.push_back(c_uvs[uv_indices[v]*2+1]);
+            } else
+            {
+                vertices.push_back(0);
+                vertices.push_back(0);
+            }
+        } else
+        {
+            indices.push_back(indices[v-repeated_verts[v]]);
+            indexing_offset++;
+        }
+    }
+
+    return true;
+}
+
+image png::read(const std::filesystem::path load_path, const bool verify)
+{
+    alpha_type alpha;
+    return read(load_path, output_format{}, alpha, verify);
+}
+
+image png::read(const std::filesystem::path load_path, const output_format format, alpha_type& alpha,
+    const bool verify)
+{
+    const mapped_file file(load_path);
+
+    size_t chunk_pos = chunks_start(file, load_path);
+
+    header info;
+    std::vector<uint8_t> pallete_vector;
+    std::vector<uint8_t> pallete_alpha;
+
+    ydeflate::inflater deflate_stream(verify);
+
+    line_decoder decoder;
+
+    image img;
+
+    //one filtered line at a time, filter type byte first
+    std::vector<uint8_t> line;
+    size_t line_filled = 0;
+    unsigned current_line = 0;
+
+    bool stored = false;
+
+    const auto decode_lines = [&]()
+    {
+        while(current_line<info.height)
+        {
+            line_filled += deflate_stream.read(line.data()+line_filled, line.size()-line_filled);
+            if(line_filled!=line.size())
+                return;
+
+            line_filled = 0;
+
+            decoder.decode(line.data(), img, current_line);
+            ++current_line;
+        }
+
+        //the checksum is only reached by reading past the last line
+        if(verify)
+        {
+            uint8_t trailing;
+            while(!deflate_stream.finished() && !deflate_stream.needs_input())
+                deflate_stream.read(&trailing, 1);
+        }
+    };
+
+    chunk current_chunk;
+    while(next_chunk(file, chunk_pos, current_chunk))
+    {
+        //the pallete transparency is the only ancillary chunk used
+        if(current_chunk.is("tRNS") && info.pallete_used)
+        {
+            check_crc(current_chunk);
+            pallete_alpha = parse_pallete_alpha(current_chunk, pallete_vector.size()/3);
+
+            continue;
+        }
+
+        if(current_chunk.ancillary())
+            continue;
+
+        check_crc(current_chunk);
+
+        if(current_chunk.is("IHDR"))
+        {
+            info = parse_header(current_chunk);
+        } else if(current_chunk.is("IDAT"))
+        {
+            //the pallete comes before the data so the lines can be decoded from the first one
+            if(line.empty())
+            {
+                decoder = line_decoder(info, pallete_vector, pallete_alpha, format);
+                line.resize(decoder.line_size());
+
+                img = image(info.width, info.height, decoder.bpp(),
+                    std::vector<uint8_t>(info.width*info.height*decoder.bpp()));
+
+                //uncompressed files get unfiltered straight from the mapped chunks
+                stored = decode_stored(file, current_chunk, chunk_pos, decoder, img, verify);
+                if(stored)
+                    current_line = info.height;
+            }
+
+            //decode every line this chunk completes, the compressed stream is never stored whole
+            //once all lines are out the rest is just the checksum
+            if(!stored && deflate_stream.needs_input())
+            {
+                //straight from the mapped file, the inflater reads it in place
+                deflate_stream.feed(current_chunk.data, current_chunk.length);
+                decode_lines();
+            }
+        } else if(current_chunk.is("PLTE"))
+        {
+            pallete_vector = parse_pallete(current_chunk);
+        } else if(current_chunk.is("IEND"))
+        {
+            const bool stream_over = stored || deflate_stream.finished();
+
+            const bool stream_left = current_line!=info.height || (verify && !stream_over);
+            if(stream_left && deflate_stream.needs_input())
+            {
+                //the last few symbols wait until the stream is known to be over
+                deflate_stream.feed(nullptr, 0, true);
+                decode_lines();
+            }
+
+            if(current_line!=info.height || (verify && !(stored || deflate_stream.finished())))
+                throw std::runtime_error("png::read image data is incomplete");
+
+            break;
+        }
+    }
+
+    alpha = decoder.alpha();
+
+    return img;
+}
+
+image png::read_pipelined(const std::filesystem::path load_path, const bool verify)
+{
+    alpha_type alpha;
+    return read_pipelined(load_path, output_format{}, alpha, verify);
+}
+
+image png::read_pipelined(const std::filesystem::path load_path, const output_format format, alpha_type& alpha,
+    const bool verify)
+{
+    const mapped_file file(load_path);
+
+    size_t chunk_pos = chunks_start(file, load_path);
+
+    header info;
+    std::vector<uint8_t> pallete_vector;
+    std::vector<uint8_t> pallete_alpha;
+
+    //everything before the image data is read here
+    size_t data_pos = chunk_pos;
+
+    chunk current_chunk;
+    while(next_chunk(file, chunk_pos, current_chunk) && !current_chunk.is("IDAT"))
+    {
+        data_pos = chunk_pos;
+
+        if(current_chunk.is("tRNS") && info.pallete_used)
+        {
+            check_crc(current_chunk);
+            pallete_alpha = parse_pallete_alpha(current_chunk, pallete_vector.size()/3);
+
+            continue;
+        }
+
+        if(current_chunk.ancillary())
+            continue;
+
+        check_crc(current_chunk);
+
+        if(current_chunk.is("IHDR"))
+        {
+            info = parse_header(current_chunk);
+        } else if(current_chunk.is("PLTE"))
+        {
+            pallete_vector = parse_pallete(current_chunk);
+        } else if(current_chunk.is("IEND"))
+        {
+            throw std::runtime_error("png::read image data is incomplete");
+        }
+    }
+
+    line_decoder decoder(info, pallete_vector, pallete_alpha, format);
+    const size_t line_size = decoder.line_size();
+
+    image img(info.width, info.height, decoder.bpp(), std::vector<uint8_t>(info.width*info.height*decoder.bpp()));
+
+    //uncompressed files only need one thread to go as fast as the memory
+    if(data_pos!=chunk_pos && decode_stored(file, current_chunk, chunk_pos, decoder, img, verify))
+    {
+        //the crcs still get checked
+        chunk_pos = data_pos;
+        while(next_chunk(file, chunk_pos, current_chunk) && !current_chunk.is("IEND"))
+        {
+            if(!current_chunk.ancillary())
+                check_crc(current_chunk);
+        }
+
+        alpha = decoder.alpha();
+
+        return img;
+    }
+
+    //bands of about 256kb, enough of them that every stage has one to work on
+    const unsigned band_lines = std::max(static_cast<size_t>(1), (1<<18)/line_size);
+    const size_t bands_num = 4;
+
+    std::vector<std::vector<uint8_t>> bands(bands_num, std::vector<uint8_t>(band_lines*line_size));
+
+    struct filled_band
+    {
+        size_t index;
+        unsigned lines;
+    };
+
+    //idat payloads go to the inflate stage, filled bands to the unfilter stage and empty bands back
+    ythreads::bounded_queue<chunk> idat_queue(64);
+    ythreads::bounded_queue<filled_band> filled_queue(bands_num);
+    ythreads::bounded_queue<size_t> empty_queue(bands_num);
+
+    for(size_t i = 0; i < bands_num; ++i)
+        empty_queue.push(i);
+
+    const auto abort_stages = [&]()
+    {
+        idat_queue.close();
+        filled_queue.close();
+        empty_queue.close();
+    };
+
+    std::promise<void> read_done;
+    std::promise<void> inflate_done;
+
+    std::future<void> read_finished = read_done.get_future();
+    std::future<void> inflate_finished = inflate_done.get_future();
+
+    std::function<void()> read_stage = [&]()
+    {
+        try
+        {
+            size_t stage_pos = data_pos;
+
+            chunk data_chunk;
+            while(next_chunk(file, stage_pos, data_chunk))
+            {
+                if(data_chunk.ancillary())
+                    continue;
+
+                //going over every byte for the crc is also what pulls the file into memory
+                check_crc(data_chunk);
+
+                if(data_chunk.is("IEND"))
+                    break;
+
+                if(data_chunk.is("IDAT") && !idat_queue.push(data_chunk))
+                    break;
+            }
+
+            idat_queue.close();
+            read_done.set_value();
+        } catch(...)
+        {
+            abort_stages();
+            read_done.set_exception(std::current_exception());
+        }
+    };
+
+    std::function<void()> inflate_stage = [&]()
+    {
+        try
+        {
+            ydeflate::inflater deflate_stream(verify);
+
+            bool input_over = false;
+            const auto feed_next = [&]() -> bool
+            {
+                if(input_over)
+                    return false;
+
+                chunk data_chunk;
+                if(idat_queue.pop(data_chunk))
+                {
+                    deflate_stream.feed(data_chunk.data, data_chunk.length);
+                } else
+                {
+                    //the last few symbols wait until the stream is known to be over
+                    deflate_stream.feed(nullptr, 0, true);
+                    input_over = true;
+                }
+
+                return true;
+            };
+
+            unsigned lines_left = info.height;
+
+            size_t band_index = 0;
+            size_t band_filled = 0;
+            bool band_taken = false;
+
+            while(lines_left!=0)
+            {
+                if(!band_taken)
+                {
+                    if(!empty_queue.pop(band_index))
+                        break;
+
+                    band_taken = true;
+                    band_filled = 0;
+                }
+
+                const unsigned lines = std::min(band_lines, lines_left);
+                std::vector<uint8_t>& band = bands[band_index];
+
+                band_filled += deflate_stream.read(band.data()+band_filled, lines*line_size-band_filled);
+
+                if(band_filled==lines*line_size)
+                {
+                    band_taken = false;
+                    lines_left -= lines;
+
+                    if(!filled_queue.push({band_index, lines}))
+                        break;
+                } else if(deflate_stream.finished() || !feed_next())
+                {
+                    break;
+                }
+            }
+
+            //the checksum is only reached by reading past the last line
+            if(verify && lines_left==0)
+            {
+                uint8_t trailing;
+                while(!deflate_stream.finished())
+                {
+                    deflate_stream.read(&trailing, 1);
+
+                    if(deflate_stream.needs_input() && !feed_next())
+                        throw std::runtime_error("png::read image data is incomplete");
+                }
+            }
+
+            //lets the read stage stop if its waiting on a full queue
+            idat_queue.close();
+            filled_queue.close();
+
+            inflate_done.set_value();
+        } catch(...)
+        {
+            abort_stages();
+            inflate_done.set_exception(std::current_exception());
+        }
+    };
+
+    unsigned current_line = 0;
+
+    {
+        typedef std::function<void()> stage_type;
+        ythreads::pool<void(*)(stage_type), stage_type> stages_pool(2, [](stage_type stage){stage();});
+
+        stages_pool.run(read_stage);
+        stages_pool.run(inflate_stage);
+
+        //unfiltering happens on this thread
+        filled_band band;
+        while(filled_queue.pop(band))
+        {
+            uint8_t* line = bands[band.index].data();
+            for(unsigned i = 0; i < band.lines; ++i, ++current_line, line += line_size)
+                decoder.decode(line, img, current_line);
+
+            empty_queue.push(band.index);
+        }
+
+        read_finished.wait();
+        inflate_finished.wait();
+    }
+
+    read_finished.get();
+    inflate_finished.get();
+
+    if(current_line!=img.height)
+        throw std::runtime_error("png::read image data is incomplete");
+
+    alpha = decoder.alpha();
+
+    return img;
+}
+
+bool png::decode_stored(const mapped_file& file, const chunk& first_chunk, size_t chunk_pos, line_decoder& decoder,
+    image& img, const bool verify)
+{
+    //the IDAT chunks all come one after another
+    std::vector<ydeflate::span> input{{first_chunk.data, first_chunk.length}};
+
+    chunk current_chunk;
+    while(next_chunk(file, chunk_pos, current_chunk) && current_chunk.is("IDAT"))
+        input.push_back({current_chunk.data, current_chunk.length});
+
+    std::vector<ydeflate::span> payload;
+    uint32_t checksum;
+    if(!ydeflate::stored_payload(input, payload, checksum))
+        return false;
+
+    const size_t line_size = decoder.line_size();
+
+    size_t payload_size = 0;
+    for(const ydeflate::span& part : payload)
+        payload_size += part.size;
+
+    if(payload_size<line_size*img.height)
+        throw std::runtime_error("png::read image data is incomplete");
+
+    //only lines going over the end of a block get copied
+    std::vector<uint8_t> line(line_size);
+
+    size_t part_index = 0;
+    size_t part_offset = 0;
+    for(unsigned y = 0; y < img.height; ++y)
+    {
+        const ydeflate::span* part = &payload[part_index];
+
+        if(part->size-part_offset>=line_size)
+        {
+            decoder.decode(part->data+part_offset, img, y);
+            part_offset += line_size;
+        } else
+        {
+            size_t line_filled = 0;
+            while(line_filled!=line_size)
+            {
+                part = &payload[part_index];
+                const size_t copy_size = std::min(line_size-line_filled, part->size-part_offset);
+
+                std::memcpy(line.data()+line_filled, part->data+part_offset, copy_size);
+                line_filled += copy_size;
+                part_offset += copy_size;
+
+                if(part_offset==part->size && line_filled!=line_size)
+                {
+                    ++part_index;
+                    part_offset = 0;
+                }
+            }
+
+            decoder.decode(line.data(), img, y);
+        }
+
+        if(part_offset==payload[part_index].size && part_index+1<payload.size())
+        {
+            ++part_index;
+            part_offset = 0;
+        }
+    }
+
+    if(verify)
+    {
+        uint32_t adler = 1;
+        for(const ydeflate::span& part : payload)
+            adler = ydeflate::adler32(adler, part.data, part.size);
+
+        if(adler!=checksum)
+            throw std::runtime_error("zlib adler32 checksum doesnt match");
+    }
+
+    return true;
+}
+
+image_info png::probe(const std::filesystem::path load_path)
+{
+    //only the pages with the first few chunks ever get read
+    const mapped_file file(load_path);
+
+    size_t chunk_pos = chunks_start(file, load_path);
+
+    chunk current_chunk;
+    if(!next_chunk(file, chunk_pos, current_chunk) || !current_chunk.is("IHDR"))
+        throw std::runtime_error("png::read IHDR chunk is missing");
+
+    check_crc(current_chunk);
+
+    const header png_header = parse_header(current_chunk);
+
+    image_info info;
+    info.width = png_header.width;
+    info.height = png_header.height;
+    info.channels = png_header.pallete_used ? 3 : png_header.values_per_pixel;
+    info.bit_depth = png_header.bit_depth;
+    info.pallete = png_header.pallete_used;
+    info.interlaced = png_header.interlaced;
+
+    //tRNS has to come before the image data
+    while(next_chunk(file, chunk_pos, current_chunk) && !current_chunk.is("IDAT"))
+    {
+        if(current_chunk.is("tRNS"))
+            info.transparency = true;
+    }
+
+    //pallete transparency gets expanded into an alpha channel
+    if(info.pallete && info.transparency)
+        info.channels = 4;
+
+    return info;
+}
+
+size_t png::chunks_start(const mapped_file& file, const std::filesystem::path& path)
+{
+    //PNG files begin with 89 50 4e 47 0d 0a 1a 0a
+    const std::array<uint8_t, 8> signature{0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a};
+    if(file.size()<signature.size() || !std::equal(signature.begin(), signature.end(), file.data()))
+        throw std::runtime_error("png::read not a png file: " + path.string());
+
+    return signature.size();
+}
+
+bool png::next_chunk(const mapped_file& file, size_t& pos, chunk& out)
+{
+    //length, type, data and crc
+    if(pos+12>file.size())
+        return false;
+
+    const uint8_t* chunk_start = file.data()+pos;
+
+    out.length = ydeflate::chars_to_number<unsigned>(reinterpret_cast<const char*>(chunk_start));
+    if(out.length>file.size()-pos-12)
+        throw std::runtime_error("png::read chunk goes past the end of the file");
+
+    out.type = chunk_start+4;
+    out.data = chunk_start+8;
+
+    pos += out.length+12;
+
+    return true;
+}
+
+void png::check_crc(const chunk& checked)
+{
+    //the crc covers the type and the data
+    const uint32_t chunk_crc = crc32(0, checked.type, checked.length+4);
+
+    if(chunk_crc!=ydeflate::chars_to_number<uint32_t>(reinterpret_cast<const char*>(checked.data+checked.length)))
+        throw std::runtime_error("png::read chunk crc doesnt match");
+}
+
+bool png::chunk::is(const char* name) const noexcept
+{
+    return std::memcmp(type, name, 4)==0;
+}
+
+bool png::chunk::ancillary() const noexcept
+{
+    //lowercase first letter
+    return type[0]&0x20;
+}
+
+png::header png::parse_header(const chunk& header_chunk)
+{
+    if(header_chunk.length<13)
+        throw std::runtime_error("png::read IHDR chunk is too short");
+
+    const char* chunk_data = reinterpret_cast<const char*>(header_chunk.data);
+
+    header info;
+
+    info.width = ydeflate::chars_to_number<unsigned>(chunk_data);
+    info.height = ydeflate::chars_to_number<unsigned>(chunk_data+4);
+
+    info.bit_depth = header_chunk.data[8];
+    const uint8_t color_type = header_chunk.data[9];
+
+    info.pallete_used = color_type&0x1;
+    info.rgb_used = (color_type>>1)&0x1;
+    info.alpha_channel = (color_type>>2)&0x1;
+
+    info.values_per_pixel = (2*info.rgb_used)+info.alpha_channel+1;
+
+    info.bpp = std::ceil((info.values_per_pixel*info.bit_depth)/8.0f);
+
+    info.interlaced = header_chunk.data[12];
+
+    return info;
+}
+
+std::vector<uint8_t> png::parse_pallete(const chunk& pallete_chunk)
+{
+    if(pallete_chunk.length%3!=0)
+        throw std::runtime_error("PLTE chunk length is not a multiple of 3");
+
+    return std::vector<uint8_t>(pallete_chunk.data, pallete_chunk.data+pallete_chunk.length);
+}
+
+std::vector<uint8_t> png::parse_pallete_alpha(const chunk& transparency_chunk, const size_t pallete_size)
+{
+    if(transparency_chunk.length>pallete_size)
+        throw std::runtime_error("tRNS chunk is longer than the pallete");
+
+    std::vector<uint8_t> pallete_alpha(pallete_size, 255);
+    std::copy(transparency_chunk.data, transparency_chunk.data+transparency_chunk.length, pallete_alpha.begin());
+
+    return pallete_alpha;
+}
+
+png::line_decoder::line_decoder(const header& info, const std::vector<uint8_t>& pallete,
+    const std::vector<uint8_t>& pallete_alpha, const output_format format)
+: _width(info.width), _height(info.height), _values_per_pixel(info.values_per_pixel),
+_bit_depth(info.bit_depth), _pallete_used(info.pallete_used), _format(format)
+{
+    if(_format.channels>4)
+        throw std::runtime_error("png::read output cant have more than 4 channels");
+
+    //only pallete indices get packed below a byte
+    const bool packed = _pallete_used && (_bit_depth==1 || _bit_depth==2 || _bit_depth==4);
+    if(_bit_depth!=8 && !packed)
+        throw std::runtime_error("png::read unsupported bit depth");
+
+    _filter_bpp = _pallete_used ? 1 : _values_per_pixel;
+    _line_size = 1+(static_cast<size_t>(info.width)*_filter_bpp*_bit_depth+7)/8;
+
+    uint8_t file_channels = _values_per_pixel;
+    if(_pallete_used)
+    {
+        _pallete_channels = pallete_alpha.empty() ? 3 : 4;
+        file_channels = _format.expand_pallete ? _pallete_channels : 1;
+
+        //every index has an entry so broken indices cant read past the end
+        _pallete.resize(256*_pallete_channels, 0);
+        for(size_t i = 0; i < std::min(static_cast<size_t>(256), pallete.size()/3); ++i)
+        {
+            std::copy(pallete.begin()+i*3, pallete.begin()+i*3+3, _pallete.begin()+i*_pallete_channels);
+
+            if(_pallete_channels==4)
+                _pallete[i*4+3] = i<pallete_alpha.size() ? pallete_alpha[i] : 255;
+        }
+    }
+
+    //raw indices dont get converted
+    _bpp = (_format.channels==0 || (_pallete_used && !_format.expand_pallete)) ? file_channels : _format.channels;
+
+    //the first one is zeros for the row above the first one
+    _rows[0].assign(_line_size-1, 0);
+    if(!direct())
+        _rows[1].assign(_line_size-1, 0);
+
+    if(_pallete_used)
+        _expanded.resize(_width*_pallete_channels);
+
+    if(packed)
+        _unpacked.resize(_width);
+}
+
+void png::line_decoder::decode(const uint8_t* line, image& img, const unsigned y) noexcept
+{
+    const uint8_t filter_type = line[0];
+    const size_t row_size = _line_size-1;
+
+    const size_t out_row_size = static_cast<size_t>(_width)*_bpp;
+    uint8_t* out = img.data.data()+(_format.flip ? _height-1-y : y)*out_row_size;
+
+    if(direct())
+    {
+        //straight into the image, the row above is already unfiltered there
+        unfilter_row(filter_type, line+1, out, _previous ? _previous : _rows[0].data(), row_size, _filter_bpp);
+        _previous = out;
+
+        write_row(out, out);
+    } else
+    {
+        //the unfiltered row is kept for the next one and converted into the image
+        uint8_t* raw = _rows[_current_row].data();
+        unfilter_row(filter_type, line+1, raw, _rows[_current_row^1].data(), row_size, _filter_bpp);
+        _current_row ^= 1;
+
+        write_row(raw, out);
+    }
+}
+
+bool png::line_decoder::direct() const noexcept
+{
+    const bool with_alpha = _bpp==2 || _bpp==4;
+    return !_pallete_used && _bpp==_values_per_pixel && !(_format.premultiply && with_alpha);
+}
+
+void png::line_decoder::write_row(const uint8_t* raw, uint8_t* out) noexcept
+{
+    const bool with_alpha = _bpp==2 || _bpp==4;
+
+    if(_pallete_used)
+    {
+        if(_bit_depth!=8)
+        {
+            //first index in the highest bits
+            const uint8_t per_byte = 8/_bit_depth;
+            const uint8_t mask = (1<<_bit_depth)-1;
+            for(unsigned x = 0; x < _width; ++x)
+                _unpacked[x] = (raw[x/per_byte]>>(8-_bit_depth-(x%per_byte)*_bit_depth))&mask;
+
+            raw = _unpacked.data();
+        }
+
+        if(!_format.expand_pallete)
+        {
+            std::memcpy(out, raw, _width);
+            return;
+        }
+
+        //looked up straight into the image if nothing else has to be done
+        const bool final_colors = _bpp==_pallete_channels && !(_format.premultiply && with_alpha);
+        uint8_t* colors = final_colors ? out : _expanded.data();
+
+        for(unsigned x = 0; x < _width; ++x, colors += _pallete_channels)
+            std::memcpy(colors, _pallete.data()+raw[x]*_pallete_channels, _pallete_channels);
+
+        if(!final_colors)
+            convert_row(_expanded.data(), _pallete_channels, out, _bpp, _width, _format.premultiply);
+    } else if(raw!=out)
+    {
+        convert_row(raw, _values_per_pixel, out, _bpp, _width, _format.premultiply);
+    }
+
+    if(with_alpha)
+    {
+        uint8_t alpha_and = _alpha_and;
+        bool alpha_partial = false;
+
+        const uint8_t* alpha = out+_bpp-1;
+        for(unsigned x = 0; x < _width; ++x, alpha += _bpp)
+        {
+            alpha_and &= *alpha;
+            //anything between 0 and 255 wraps to below 254
+            alpha_partial |= static_cast<uint8_t>(*alpha-1)<254;
+        }
+
+        _alpha_and = alpha_and;
+        _alpha_partial = _alpha_partial || alpha_partial;
+    }
+}
+
+size_t png::line_decoder::line_size() const noexcept
+{
+    return _line_size;
+}
+
+uint8_t png::line_decoder::bpp() const noexcept
+{
+    return _bpp;
+}
+
+alpha_type png::line_decoder::alpha() const noexcept
+{
+    if(_alpha_and==255)
+        return alpha_type::opaque;
+
+    return _alpha_partial ? alpha_type::translucent : alpha_type::binary;
+}
+
+template<int in_channels, int out_channels>
+void png::convert_row(const uint8_t* in, uint8_t* out, const unsigned width, const bool premultiply) noexcept
+{
+    constexpr bool in_alpha = in_channels==2 || in_channels==4;
+    constexpr bool out_alpha = out_channels==2 || out_channels==4;
+
+    const bool multiply = premultiply && in_alpha && out_alpha;
+
+    for(unsigned x = 0; x < width; ++x, in += in_channels, out += out_channels)
+    {
+        //gray spreads over every color
+        uint8_t r = in[0];
+        uint8_t g = in[0];
+        uint8_t b = in[0];
+        if constexpr(in_channels>2)
+        {
+            g = in[1];
+            b = in[2];
+        }
+
+        const uint8_t a = in_alpha ? in[in_channels-1] : 255;
+
+        if(multiply)
+        {
+            r = multiply_alpha(r, a);
+            g = multiply_alpha(g, a);
+            b = multiply_alpha(b, a);
+        }
+
+        if constexpr(out_channels>2)
+        {
+            out[0] = r;
+            out[1] = g;
+            out[2] = b;
+        } else
+        {
+            //same weights as pixels::luminance, so decoding to gray gives what converting afterwards would
+            out[0] = in_channels>2 ? (r*luma_red+g*luma_green+b*luma_blue+128)>>8 : r;
+        }
+
+        if constexpr(out_alpha)
+            out[out_channels-1] = a;
+    }
+}
+
+void png::convert_row(const uint8_t* in, const uint8_t in_channels, uint8_t* out, const uint8_t out_channels,
+    const unsigned width, const bool premultiply) noexcept
+{
+    typedef void (*convert_func)(const uint8_t*, uint8_t*, const unsigned, const bool);
+    static constexpr convert_func converters[4][4]{
+        {convert_row<1, 1>, convert_row<1, 2>, convert_row<1, 3>, convert_row<1, 4>},
+        {convert_row<2, 1>, convert_row<2, 2>, convert_row<2, 3>, convert_row<2, 4>},
+        {convert_row<3, 1>, convert_row<3, 2>, convert_row<3, 3>, convert_row<3, 4>},
+        {convert_row<4, 1>, convert_row<4, 2>, convert_row<4, 3>, convert_row<4, 4>}};
+
+    converters[in_channels-1][out_channels-1](in, out, width, premultiply);
+}
+
+
+void png::save(const image_view& img, const std::filesystem::path save_path, const int level, const unsigned threads_num,
+    const filter_strategy strategy, const size_t chunk_size)
+{
+    //1 or 2 channels are already as small as 8 bit indices
+    if(img.bpp==3 || img.bpp==4)
+    {
+        indexed_image indexed;
+        if(find_pallete(img, indexed))
+        {
+            save(indexed, save_path, level, threads_num, strategy, chunk_size);
+            return;
+        }
+    }
+
+    std::ofstream out_stream(save_path, std::ios::binary);
+    write_signature(out_stream);
+
+    chunk_writer writer(out_stream, chunk_size);
+
+    const std::vector<uint8_t> header = header_data(img);
+    writer.write_chunk("IHDR", header.data(), header.size());
+
+    write_image_data(img, writer, level, threads_num, strategy);
+
+    writer.write_chunk("IEND", nullptr, 0);
+}
+
+void png::save(const indexed_image& img, const std::filesystem::path save_path, const int level,
+    const unsigned threads_num, const filter_strategy strategy, const size_t chunk_size)
+{
+    const size_t colors = img.colors();
+    if(colors==0 || colors>256)
+        throw std::runtime_error("png::save pallete has to have between 1 and 256 colors");
+
+    std::ofstream out_stream(save_path, std::ios::binary);
+    write_signature(out_stream);
+
+    chunk_writer writer(out_stream, chunk_size);
+
+    const std::vector<uint8_t> header = header_data(img);
+    writer.write_chunk("IHDR", header.data(), header.size());
+
+    std::vector<uint8_t> pallete(colors*3);
+    for(size_t i = 0; i < colors; ++i)
+        std::copy(img.pallete.begin()+i*4, img.pallete.begin()+i*4+3, pallete.begin()+i*3);
+
+    writer.write_chunk("PLTE", pallete.data(), pallete.size());
+
+    //the translucent entries are at the front, the rest default to opaque
+    std::vector<uint8_t> pallete_alpha;
+    for(size_t i = 0; i < colors && img.pallete[i*4+3]!=255; ++i)
+        pallete_alpha.push_back(img.pallete[i*4+3]);
+
+    //otherwise the image would be read back without its alpha channel
+    const bool with_alpha = img.channels==2 || img.channels==4;
+    if(pallete_alpha.empty() && with_alpha)
+        pallete_alpha.push_back(img.pallete[3]);
+
+    if(!pallete_alpha.empty())
+        writer.write_chunk("tRNS", pallete_alpha.data(), pallete_alpha.size());
+
+    write_image_data(packed_indices(img), writer, level, threads_num, strategy);
+
+    writer.write_chunk("IEND", nullptr, 0);
+}
+
+void png::write_signature(std::ostream& stream)
+{
+    //magic numbers for png, PNG in ascii and line endings
+    const std::array<char, 8> signature{static_cast<char>(0x89), 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a};
+    stream.write(signature.data(), signature.size());
+}
+
+size_t png::indexed_image::colors() const noexcept
+{
+    return pallete.size()/4;
+}
+
+uint8_t png::indexed_image::bit_depth() const noexcept
+{
+    const size_t colors_num = colors();
+    if(colors_num<=2)
+        return 1;
+
+    if(colors_num<=4)
+        return 2;
+
+    return colors_num<=16 ? 4 : 8;
+}
+
+namespace
+{
+    //rgba packed with red in the lowest byte, gray is spread to every color
+    inline uint32_t pixel_rgba(const uint8_t* pixel, const uint8_t bpp) noexcept
+    {
+        switch(bpp)
+        {
+            case 1:
+                return pixel[0]*0x010101u|0xff000000u;
+            case 2:
+                return pixel[0]*0x010101u|static_cast<uint32_t>(pixel[1])<<24;
+            case 3:
+                return pixel[0]|pixel[1]<<8|pixel[2]<<16|0xff000000u;
+            default:
+                return pixel[0]|pixel[1]<<8|pixel[2]<<16|static_cast<uint32_t>(pixel[3])<<24;
+        }
+    }
+
+    inline uint8_t key_channel(const uint32_t key, const int channel) noexcept
+    {
+        return (key>>(channel*8))&0xff;
+    }
+}
+
+bool png::find_pallete(const image_view& img, indexed_image& out)
+{
+    const size_t pixels = static_cast<size_t>(img.width)*img.height;
+    if(pixels==0 || img.bpp==0 || img.bpp>4)
+        return false;
+
+    //open addressing with twice the slots of the colors that can fit, so it never fills up
+    //entries hold the index+1, 0 is an empty slot
+    constexpr unsigned slots = 512;
+    std::array<uint32_t, slots> keys{};
+    std::array<uint16_t, slots> entries{};
+
+    std::vector<uint32_t> colors;
+    colors.reserve(256);
+
+    std::vector<uint8_t> indices(pixels);
+
+    uint32_t last_key = 0;
+    uint8_t last_index = 0;
+
+    for(size_t i = 0; i < pixels; ++i)
+    {
+        const uint32_t key = pixel_rgba(img.row(i/img.width)+(i%img.width)*img.bpp, img.bpp);
+
+        //runs of the same color skip the lookup
+        if(i!=0 && key==last_key)
+        {
+            indices[i] = last_index;
+            continue;
+        }
+
+        unsigned slot = (key*0x9e3779b1u)>>23;
+        while(entries[slot]!=0 && keys[slot]!=key)
+            slot = (slot+1)&(slots-1);
+
+        if(entries[slot]==0)
+        {
+            if(colors.size()==256)
+                return false;
+
+            colors.push_back(key);
+            keys[slot] = key;
+            entries[slot] = colors.size();
+        }
+
+        last_key = key;
+        last_index = entries[slot]-1;
+        indices[i] = last_index;
+    }
+
+    out.width = img.width;
+    out.height = img.height;
+    out.channels = img.bpp;
+
+    out.pallete.resize(colors.size()*4);
+    for(size_t i = 0; i < colors.size(); ++i)
+    {
+        for(int c = 0; c < 4; ++c)
+            out.pallete[i*4+c] = key_channel(colors[i], c);
+    }
+
+    out.indices = std::move(indices);
+
+    sort_pallete(out);
+
+    return true;
+}
+
+png::indexed_image png::quantize(const image_view& img, const unsigned colors)
+{
+    if(colors==0 || colors>256)
+        throw std::runtime_error("png::quantize can only make 1 to 256 colors");
+
+    if(img.bpp==0 || img.bpp>4)
+        throw std::runtime_error("png::quantize invalid bpp");
+
+    const size_t pixels = static_cast<size_t>(img.width)*img.height;
+
+    std::vector<uint32_t> keys(pixels);
+    for(size_t i = 0; i < pixels; ++i)
+        keys[i] = pixel_rgba(img.row(i/img.width)+(i%img.width)*img.bpp, img.bpp);
+
+    //every distinct color and how many pixels have it
+    std::vector<uint32_t> sorted(keys);
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<std::pair<uint32_t, size_t>> histogram;
+    for(const uint32_t key : sorted)
+    {
+        if(histogram.empty() || histogram.back().first!=key)
+        {
+            histogram.emplace_back(key, 1);
+        } else
+        {
+            ++histogram.back().second;
+        }
+    }
+
+    std::vector<uint32_t>().swap(sorted);
+
+    //ranges of the histogram, the box with the widest channel gets split at its median until there are enough
+    std::vector<std::pair<size_t, size_t>> boxes;
+    if(!histogram.empty())
+        boxes.emplace_back(0, histogram.size());
+
+    while(boxes.size()<colors)
+    {
+        size_t widest_box = boxes.size();
+        int widest_channel = 0;
+        int widest_range = -1;
+        for(size_t b = 0; b < boxes.size(); ++b)
+        {
+            if(boxes[b].second-boxes[b].first<2)
+                continue;
+
+            for(int c = 0; c < 4; ++c)
+            {
+                uint8_t low = 255;
+                uint8_t high = 0;
+                for(size_t i = boxes[b].first; i < boxes[b].second; ++i)
+                {
+                    const uint8_t value = key_channel(histogram[i].first, c);
+                    low = std::min(low, value);
+                    high = std::max(high, value);
+                }
+
+                if(high-low>widest_range)
+                {
+                    widest_box = b;
+                    widest_channel = c;
+                    widest_range = high-low;
+                }
+            }
+        }
+
+        //every box is a single color
+        if(widest_box==boxes.size())
+            break;
+
+        const auto [begin, end] = boxes[widest_box];
+        std::sort(histogram.begin()+begin, histogram.begin()+end,
+            [widest_channel](const auto& a, const auto& b)
+            {
+                return key_channel(a.first, widest_channel)<key_channel(b.first, widest_channel);
+            });
+
+        size_t total = 0;
+        for(size_t i = begin; i < end; ++i)
+            total += histogram[i].second;
+
+        //both halves keep at least one color
+        size_t split = begin+1;
+        for(size_t counted = histogram[begin].second; split < end-1 && counted*2<total; ++split)
+            counted += histogram[split].second;
+
+        boxes[widest_box].second = split;
+        boxes.emplace_back(split, end);
+    }
+
+    indexed_image out;
+    out.width = img.width;
+    out.height = img.height;
+    out.channels = img.bpp;
+
+    //each box becomes the average of its colors, weighted by the pixels
+    std::vector<std::pair<uint32_t, uint8_t>> lookup;
+    lookup.reserve(histogram.size());
+
+    out.pallete.resize(boxes.size()*4);
+    for(size_t b = 0; b < boxes.size(); ++b)
+    {
+        std::array<uint64_t, 4> sums{};
+        size_t total = 0;
+        for(size_t i = boxes[b].first; i < boxes[b].second; ++i)
+        {
+            for(int c = 0; c < 4; ++c)
+                sums[c] += key_channel(histogram[i].first, c)*static_cast<uint64_t>(histogram[i].second);
+
+            total += histogram[i].second;
+            lookup.emplace_back(histogram[i].first, b);
+        }
+
+        for(int c = 0; c < 4; ++c)
+            out.pallete[b*4+c] = (sums[c]+total/2)/total;
+    }
+
+    std::sort(lookup.begin(), lookup.end());
+
+    out.indices.resize(pixels);
+
+    uint32_t last_key = 0;
+    uint8_t last_index = 0;
+    for(size_t i = 0; i < pixels; ++i)
+    {
+        if(i==0 || keys[i]!=last_key)
+        {
+            last_key = keys[i];
+            last_index = std::lower_bound(lookup.begin(), lookup.end(), std::make_pair(last_key, uint8_t(0)))->second;
+        }
+
+        out.indices[i] = last_index;
+    }
+
+    sort_pallete(out);
+
+    return out;
+}
+
+void png::sort_pallete(indexed_image& img)
+{
+    const size_t colors = img.colors();
+
+    std::vector<uint8_t> order(colors);
+    for(size_t i = 0; i < colors; ++i)
+        order[i] = i;
+
+    std::stable_partition(order.begin(), order.end(), [&img](const uint8_t entry)
+        {
+            return img.pallete[entry*4+3]!=255;
+        });
+
+    std::array<uint8_t, 256> remap{};
+    std::vector<uint8_t> pallete(colors*4);
+    for(size_t i = 0; i < colors; ++i)
+    {
+        remap[order[i]] = i;
+        std::copy(img.pallete.begin()+order[i]*4, img.pallete.begin()+order[i]*4+4, pallete.begin()+i*4);
+    }
+
+    img.pallete = std::move(pallete);
+
+    for(uint8_t& index : img.indices)
+        index = remap[index];
+}
+
+yconv::image png::packed_indices(const indexed_image& img)
+{
+    const uint8_t bit_depth = img.bit_depth();
+    const uint8_t per_byte = 8/bit_depth;
+
+    image packed;
+    packed.width = (static_cast<size_t>(img.width)*bit_depth+7)/8;
+    packed.height = img.height;
+    packed.bpp = 1;
+    packed.data.assign(static_cast<size_t>(packed.width)*packed.height, 0);
+
+    for(unsigned y = 0; y < img.height; ++y)
+    {
+        const uint8_t* indices = img.indices.data()+static_cast<size_t>(y)*img.width;
+        uint8_t* row = packed.data.data()+static_cast<size_t>(y)*packed.width;
+
+        if(bit_depth==8)
+        {
+            std::memcpy(row, indices, img.width);
+            continue;
+        }
+
+        //first index in the highest bits
+        for(unsigned x = 0; x < img.width; ++x)
+            row[x/per_byte] |= indices[x]<<(8-bit_depth-(x%per_byte)*bit_depth);
+    }
+
+    return packed;
+}
+
+std::vector<char> png::create_chunk(const image_view& img, const std::string name, const int level,
+    const unsigned threads_num, const filter_strategy strategy)
+{
+    if(name=="IDAT")
+    {
+        std::ostringstream out_stream(std::ios::binary);
+
+        chunk_writer writer(out_stream);
+        write_image_data(img, writer, level, threads_num, strategy);
+
+        const std::string chunks = out_stream.str();
+        return std::vector<char>(chunks.begin(), chunks.end());
+    }
+
+    std::vector<char> data_chunk;
+
+    chunk_header(name, data_chunk);
+
+    if(name=="IHDR")
+    {
+        const std::vector<uint8_t> header = header_data(img);
+        data_chunk.insert(data_chunk.end(), header.begin(), header.end());
+    }
+
+    chunk_ending(data_chunk);
+
+    return data_chunk;
+}
+
+std::vector<uint8_t> png::header_data(const image_view& img)
+{
+    std::vector<uint8_t> data_chunk;
+    data_chunk.reserve(13);
+
+    //4 bytes of width
+    data_chunk.push_back((img.width&0xff000000)>>24);
+    data_chunk.push_back((img.width&0xff0000)>>16);
+    data_chunk.push_back((img.width&0xff00)>>8);
+    data_chunk.push_back(img.width&0xff);
+
+    //4 bytes of height
+    data_chunk.push_back((img.height&0xff000000)>>24);
+    data_chunk.push_back((img.height&0xff0000)>>16);
+    data_chunk.push_back((img.height&0xff00)>>8);
+    data_chunk.push_back(img.height&0xff);
+
+    //bits per pixel, always 8 (bla bla bla not efficient)
+    data_chunk.push_back(8);
+
+    //color type
+    //0100 bit adds alpha
+    //0010 bit adds color
+    //0001 bit means color from pallete
+    switch(img.bpp)
+    {
+        case 1:
+            //grayscale
+            data_chunk.push_back(0);
+            break;
+        case 2:
+            //grayscale with alpha
+            data_chunk.push_back(4);
+            break;
+        case 3:
+            //fullcolor
+            data_chunk.push_back(2);
+            break;
+        case 4:
+            //fullcolor with alpha
+            data_chunk.push_back(6);
+            break;
+
+        default:
+            throw std::runtime_error("invalid IHDR bpp type");
+    }
+
+    //stuff that doesnt change, like png using deflate algorithm for compression
+    data_chunk.push_back(0);
+    data_chunk.push_back(0);
+
+    //interlacing off
+    data_chunk.push_back(0);
+
+    return data_chunk;
+}
+
+std::vector<uint8_t> png::header_data(const indexed_image& img)
+{
+    std::vector<uint8_t> data_chunk;
+    data_chunk.reserve(13);
+
+    //4 bytes of width
+    data_chunk.push_back((img.width&0xff000000)>>24);
+    data_chunk.push_back((img.width&0xff0000)>>16);
+    data_chunk.push_back((img.width&0xff00)>>8);
+    data_chunk.push_back(img.width&0xff);
+
+    //4 bytes of height
+    data_chunk.push_back((img.height&0xff000000)>>24);
+    data_chunk.push_back((img.height&0xff0000)>>16);
+    data_chunk.push_back((img.height&0xff00)>>8);
+    data_chunk.push_back(img.height&0xff);
+
+    //bits per index
+    data_chunk.push_back(img.bit_depth());
+
+    //color from pallete, with color
+    data_chunk.push_back(3);
+
+    data_chunk.push_back(0);
+    data_chunk.push_back(0);
+
+    //interlacing off
+    data_chunk.push_back(0);
+
+    return data_chunk;
+}
+
+void png::write_image_data(const image_view& img, chunk_writer& writer, const int level, const unsigned threads_num,
+    const filter_strategy strategy)
+{
+    const size_t lines = band_lines(1+static_cast<size_t>(img.width)*img.bpp);
+    const size_t bands_num = (img.height+lines-1)/lines;
+
+    const unsigned workers = std::min(static_cast<size_t>(threads_num==0 ? std::thread::hardware_concurrency() : threads_num),
+        bands_num);
+
+    //brute_force tries every line on the stream it goes into, so the lines cant be split between streams
+    if(workers>1 && strategy!=filter_strategy::brute_force)
+    {
+        write_image_bands(img, writer, level, workers, strategy);
+    } else
+    {
+        //compressed as the lines get filtered and written out once theres a chunks worth
+        ydeflate::deflater deflate_stream(level);
+
+        filter_selector filter(img, strategy, deflate_stream);
+
+        for(unsigned y = 0; y < img.height; ++y)
+        {
+            deflate_stream.write(filter.line(y), filter.line_size());
+
+            const std::vector<uint8_t> compressed = deflate_stream.take_output();
+            writer.write_data(compressed.data(), compressed.size());
+        }
+
+        deflate_stream.finish();
+
+        const std::vector<uint8_t> compressed = deflate_stream.take_output();
+        writer.write_data(compressed.data(), compressed.size());
+    }
+
+    writer.finish_data();
+}
+
+size_t png::band_lines(const size_t line_size) noexcept
+{
+    return std::max(static_cast<size_t>(1), parallel_band_size/line_size);
+}
+
+void png::write_image_bands(const image_view& img, chunk_writer& writer, const int level, const unsigned workers,
+    const filter_strategy strategy)
+{
+    const size_t line_size = 1+static_cast<size_t>(img.width)*img.bpp;
+    const unsigned lines = band_lines(line_size);
+
+    const size_t bands_num = (img.height+lines-1)/lines;
+
+    //only a few bands are held at a time, the rest wait until theyre written
+    const size_t in_flight = std::min(bands_num, static_cast<size_t>(workers)*2);
+
+    std::vector<encode_job> jobs(bands_num);
+    std::vector<std::future<void>> finished(bands_num);
+
+    const std::array<uint8_t, 2> header = ydeflate::zlib_header(level);
+    writer.write_data(header.data(), header.size());
+
+    uint32_t adler = 1;
+
+    std::exception_ptr failed;
+
+    {
+        ythreads::pool<void(*)(encode_job*), encode_job*> workers_pool(workers, encode_band);
+
+        size_t submitted = 0;
+        const auto submit = [&]()
+        {
+            encode_job& job = jobs[submitted];
+
+            job.img = img;
+            job.start_row = submitted*lines;
+            job.rows = std::min(lines, img.height-job.start_row);
+            job.level = level;
+            job.strategy = strategy;
+            job.last = submitted==bands_num-1;
+
+            job.previous = nullptr;
+            if(submitted!=0)
+            {
+                job.previous = &jobs[submitted-1].filtered;
+                job.previous_filtered = jobs[submitted-1].filtered_done.get_future();
+            }
+
+            finished[submitted] = job.done.get_future();
+            workers_pool.run(&job);
+
+            ++submitted;
+        };
+
+        while(submitted<in_flight)
+            submit();
+
+        for(size_t i = 0; i < bands_num; ++i)
+        {
+            try
+            {
+                //rethrows whatever the worker threw
+                finished[i].get();
+            } catch(...)
+            {
+                failed = std::current_exception();
+                break;
+            }
+
+            writer.write_data(jobs[i].output.data(), jobs[i].output.size());
+            adler = ydeflate::adler32_combine(adler, jobs[i].adler, jobs[i].filtered.size());
+
+            //the band after this one already has its dictionary
+            if(i!=0)
+                std::vector<uint8_t>().swap(jobs[i-1].filtered);
+            std::vector<uint8_t>().swap(jobs[i].output);
+
+            if(submitted<bands_num)
+                submit();
+        }
+
+        //the pool drops queued jobs when its destroyed, so everything has to finish first
+        for(size_t i = 0; i < submitted; ++i)
+        {
+            if(finished[i].valid())
+                finished[i].wait();
+        }
+    }
+
+    if(failed)
+        std::rethrow_exception(failed);
+
+    const std::array<uint8_t, 4> checksum{
+        static_cast<uint8_t>((adler>>24)&0xff), static_cast<uint8_t>((adler>>16)&0xff),
+        static_cast<uint8_t>((adler>>8)&0xff), static_cast<uint8_t>(adler&0xff)};
+
+    writer.write_data(checksum.data(), checksum.size());
+}
+
+void png::encode_band(encode_job* job)
+{
+    bool filtered = false;
+
+    try
+    {
+        //raw so the bands can be put one after another, the zlib header and checksum get added around them
+        ydeflate::deflater stream(job->level, true);
+
+        //brute_force never gets here, so the lines are picked without touching the stream
+        filter_selector filter(job->img, job->strategy, stream);
+
+        job->filtered.reserve(job->rows*filter.line_size());
+        for(unsigned y = job->start_row; y < job->start_row+job->rows; ++y)
+        {
+            const uint8_t* line = filter.line(y);
+            job->filtered.insert(job->filtered.end(), line, line+filter.line_size());
+        }
+
+        filtered = true;
+        job->filtered_done.set_value();
+
+        //the end of the band before is what the stream gets primed with
+        if(job->previous)
+        {
+            job->previous_filtered.get();
+
+            const size_t dictionary_size = std::min(job->previous->size(), static_cast<size_t>(32768));
+            stream.set_dictionary(job->previous->data()+job->previous->size()-dictionary_size, dictionary_size);
+        }
+
+        stream.write(job->filtered.data(), job->filtered.size());
+
+        //a sync flush ends the band on a whole byte so the next one can follow it
+        if(job->last)
+        {
+            stream.finish();
+        } else
+        {
+            stream.flush();
+        }
+
+        job->output = stream.take_output();
+        job->adler = stream.checksum();
+
+        job->done.set_value();
+    } catch(...)
+    {
+        //the next band waits on this one
+        if(!filtered)
+            job->filtered_done.set_exception(std::current_exception());
+
+        job->done.set_exception(std::current_exception());
+    }
+}
+
+void png::chunk_header(const std::string name, std::vector<char>& write_data) noexcept
+{
+    //the length goes first but its only known at the end
+    write_data.resize(write_data.size()+4);
+
+    for(int cn = 0; cn < 4; ++cn)
+        write_data.emplace_back(name[cn]);
+}
+
+void png::chunk_ending(std::vector<char>& write_data) noexcept
+{
+    //everything after the length
+    const int crc_length = write_data.size()-4;
+
+    const uint32_t chunk_crc = crc32(0, reinterpret_cast<const uint8_t*>(write_data.data()+4), crc_length);
+
+    const int chunk_length = crc_length-4; //remove the name bytes
+
+    write_data[0] = (chunk_length&0xff000000)>>24;
+    write_data[1] = (chunk_length&0xff0000)>>16;
+    write_data[2] = (chunk_length&0xff00)>>8;
+    write_data[3] = chunk_length&0xff;
+
+    write_data.push_back((chunk_crc&0xff000000)>>24);
+    write_data.push_back((chunk_crc&0xff0000)>>16);
+    write_data.push_back((chunk_crc&0xff00)>>8);
+    write_data.push_back(chunk_crc&0xff);
+}
+
+png::chunk_writer::chunk_writer(std::ostream& stream, const size_t chunk_size)
+: _stream(stream), _chunk_size(chunk_size)
+{
+    assert(chunk_size>0);
+
+    _data.reserve(chunk_size);
+}
+
+void png::chunk_writer::write_chunk(const char* name, const uint8_t* data, const size_t size)
+{
+    const uint32_t chunk_crc = crc32(crc32(0, reinterpret_cast<const uint8_t*>(name), 4), data, size);
+
+    write_chunk(name, data, size, chunk_crc);
+}
+
+void png::chunk_writer::write_data(const uint8_t* data, size_t size)
+{
+    while(size!=0)
+    {
+        if(_data.empty())
+            _crc = crc32(0, reinterpret_cast<const uint8_t*>("IDAT"), 4);
+
+        const size_t copy_size = std::min(size, _chunk_size-_data.size());
+
+        _data.insert(_data.end(), data, data+copy_size);
+        _crc = crc32(_crc, data, copy_size);
+
+        data += copy_size;
+        size -= copy_size;
+
+        if(_data.size()==_chunk_size)
+        {
+            write_chunk("IDAT", _data.data(), _data.size(), _crc);
+            _data.clear();
+        }
+    }
+}
+
+void png::chunk_writer::finish_data()
+{
+    if(_data.empty())
+        return;
+
+    write_chunk("IDAT", _data.data(), _data.size(), _crc);
+    _data.clear();
+}
+
+void png::chunk_writer::write_chunk(const char* name, const uint8_t* data, const size_t size, const uint32_t crc)
+{
+    const std::array<char, 8> header{
+        static_cast<char>((size>>24)&0xff), static_cast<char>((size>>16)&0xff),
+        static_cast<char>((size>>8)&0xff), static_cast<char>(size&0xff),
+        name[0], name[1], name[2], name[3]};
+
+    const std::array<char, 4> ending{
+        static_cast<char>((crc>>24)&0xff), static_cast<char>((crc>>16)&0xff),
+        static_cast<char>((crc>>8)&0xff), static_cast<char>(crc&0xff)};
+
+    _stream.write(header.data(), header.size());
+    _stream.write(reinterpret_cast<const char*>(data), size);
+    _stream.write(ending.data(), ending.size());
+}
+
+void png::unfilter_row(const uint8_t filter, const uint8_t* in, uint8_t* out, const uint8_t* previous,
+    const size_t size, const uint8_t bpp) noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if(filter==2)
+    {
+        typedef void (*up_func)(const uint8_t*, uint8_t*, const uint8_t*, const size_t);
+        static const up_func best_up = __builtin_cpu_supports("avx2") ? unfilter_up_avx2 : unfilter_up_sse2;
+
+        best_up(in, out, previous, size);
+        return;
+    }
+
+    if(bpp==3 || bpp==4)
+    {
+        switch(filter)
+        {
+            case 1:
+                bpp==3 ? unfilter_sub_sse2<3>(in, out, size) : unfilter_sub_sse2<4>(in, out, size);
+                return;
+
+            case 3:
+                bpp==3 ? unfilter_average_sse2<3>(in, out, previous, size)
+                    : unfilter_average_sse2<4>(in, out, previous, size);
+                return;
+
+            case 4:
+                bpp==3 ? unfilter_paeth_sse2<3>(in, out, previous, size)
+                    : unfilter_paeth_sse2<4>(in, out, previous, size);
+                return;
+        }
+    }
+#endif
+
+    switch(bpp)
+    {
+        case 1:
+            unfilter_row_scalar<1>(filter, in, out, previous, size, bpp);
+            break;
+        case 2:
+            unfilter_row_scalar<2>(filter, in, out, previous, size, bpp);
+            break;
+        case 3:
+            unfilter_row_scalar<3>(filter, in, out, previous, size, bpp);
+            break;
+        case 4:
+            unfilter_row_scalar<4>(filter, in, out, previous, size, bpp);
+            break;
+
+        default:
+            unfilter_row_scalar<0>(filter, in, out, previous, size, bpp);
+            break;
+    }
+}
+
+template<int bpp_t>
+void png::unfilter_row_scalar(const uint8_t filter, const uint8_t* in, uint8_t* out, const uint8_t* previous,
+    const size_t size, const uint8_t bpp_runtime) noexcept
+{
+    const size_t bpp = bpp_t==0 ? bpp_runtime : bpp_t;
+    const size_t first = std::min(bpp, size);
+
+    switch(filter)
+    {
+        default:
+        case 0:
+            if(in!=out)
+                std::memcpy(out, in, size);
+            return;
+
+        case 1:
+            std::copy(in, in+first, out);
+            for(size_t i = first; i < size; ++i)
+                out[i] = in[i]+out[i-bpp];
+            return;
+
+        case 2:
+            for(size_t i = 0; i < size; ++i)
+                out[i] = in[i]+previous[i];
+            return;
+
+        case 3:
+            //the first pixel has nothing on the left so its just half of the one above
+            for(size_t i = 0; i < first; ++i)
+                out[i] = in[i]+(previous[i]>>1);
+            for(size_t i = first; i < size; ++i)
+                out[i] = in[i]+((out[i-bpp]+previous[i])>>1);
+            return;
+
+        case 4:
+            //and paeth always picks the one above
+            for(size_t i = 0; i < first; ++i)
+                out[i] = in[i]+previous[i];
+            for(size_t i = first; i < size; ++i)
+            {
+                //same as paeth_predictor but without branches
+                int predicted = out[i-bpp];
+                const int up = previous[i];
+                const int up_left = previous[i-bpp];
+
+                int distance = std::abs(up-up_left);
+                const int distance_up = std::abs(predicted-up_left);
+                const int distance_up_left = std::abs(predicted+up-2*up_left);
+
+                if(distance_up<distance)
+                {
+                    distance = distance_up;
+                    predicted = up;
+                }
+
+                if(distance_up_left<distance)
+                    predicted = up_left;
+
+                out[i] = in[i]+predicted;
+            }
+            return;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+namespace
+{
+    //reads and writes of a single pixel into the low lane
+    template<int bpp>
+    __m128i load_pixel(const uint8_t* data) noexcept
+    {
+        uint32_t pixel;
+        if constexpr(bpp==4)
+        {
+            std::memcpy(&pixel, data, 4);
+        } else
+        {
+            pixel = data[0]|(data[1]<<8)|(data[2]<<16);
+        }
+
+        return _mm_cvtsi32_si128(pixel);
+    }
+
+    template<int bpp>
+    void store_pixel(uint8_t* data, const __m128i pixel) noexcept
+    {
+        const uint32_t value = _mm_cvtsi128_si32(pixel);
+        if constexpr(bpp==4)
+        {
+            std::memcpy(data, &value, 4);
+        } else
+        {
+            data[0] = value;
+            data[1] = value>>8;
+            data[2] = value>>16;
+        }
+    }
+}
+
+void png::unfilter_up_sse2(const uint8_t* in, uint8_t* out, const uint8_t* previous, const size_t size) noexcept
+{
+    size_t i = 0;
+    for(; i+16 <= size; i += 16)
+    {
+        const __m128i filtered = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in+i));
+        const __m128i above = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous+i));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i), _mm_add_epi8(filtered, above));
+    }
+
+    for(; i < size; ++i)
+        out[i] = in[i]+previous[i];
+}
+
+__attribute__((target("avx2")))
+void png::unfilter_up_avx2(const uint8_t* in, uint8_t* out, const uint8_t* previous, const size_t size) noexcept
+{
+    size_t i = 0;
+    for(; i+32 <= size; i += 32)
+    {
+        const __m256i filtered = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in+i));
+        const __m256i above = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(previous+i));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out+i), _mm256_add_epi8(filtered, above));
+    }
+
+    unfilter_up_sse2(in+i, out+i, previous+i, size-i);
+}
+
+template<int bpp>
+void png::unfilter_sub_sse2(const uint8_t* in, uint8_t* out, const size_t size) noexcept
+{
+    //4 pixels at once as a prefix sum, the last pixel carries into the next group
+    __m128i left = _mm_setzero_si128();
+
+    size_t i = 0;
+    for(; i+16 <= size; i += bpp*4)
+    {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in+i));
+
+        pixels = _mm_add_epi8(pixels, _mm_slli_si128(pixels, bpp));
+        pixels = _mm_add_epi8(pixels, _mm_slli_si128(pixels, bpp*2));
+        pixels = _mm_add_epi8(pixels, left);
+
+        if constexpr(bpp==4)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i), pixels);
+            left = _mm_shuffle_epi32(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+        } else
+        {
+            //only the first 12 bytes are whole pixels
+            uint8_t group[16];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(group), pixels);
+            std::memcpy(out+i, group, bpp*4);
+
+            const __m128i last = load_pixel<bpp>(group+bpp*3);
+            left = _mm_or_si128(last, _mm_slli_si128(last, 3));
+            left = _mm_or_si128(left, _mm_slli_si128(left, 6));
+        }
+    }
+
+    //rest one pixel at a time
+    __m128i pixel = i==0 ? _mm_setzero_si128() : load_pixel<bpp>(out+i-bpp);
+    for(; i+bpp <= size; i += bpp)
+    {
+        pixel = _mm_add_epi8(load_pixel<bpp>(in+i), pixel);
+        store_pixel<bpp>(out+i, pixel);
+    }
+
+    for(; i < size; ++i)
+        out[i] = in[i]+(i<bpp ? 0 : out[i-bpp]);
+}
+
+template<int bpp>
+void png::unfilter_average_sse2(const uint8_t* in, uint8_t* out, const uint8_t* previous, const size_t size) noexcept
+{
+    //the first pixel averages with zero so the left one just starts empty
+    __m128i left = _mm_setzero_si128();
+
+    size_t i = 0;
+    for(; i+bpp <= size; i += bpp)
+    {
+        const __m128i above = load_pixel<bpp>(previous+i);
+
+        //png averages round down but avg_epu8 rounds up, so take the odd bit back off
+        __m128i average = _mm_avg_epu8(left, above);
+        average = _mm_sub_epi8(average, _mm_and_si128(_mm_xor_si128(left, above), _mm_set1_epi8(1)));
+
+        left = _mm_add_epi8(load_pixel<bpp>(in+i), average);
+        store_pixel<bpp>(out+i, left);
+    }
+
+    for(; i < size; ++i)
+        out[i] = in[i]+(((i<bpp ? 0 : out[i-bpp])+previous[i])>>1);
+}
+
+template<int bpp>
+void png::unfilter_paeth_sse2(const uint8_t* in, uint8_t* out, const uint8_t* previous, const size_t size) noexcept
+{
+    //same as libpngs version, 16 bit lanes so the distances dont overflow
+    //with the left and up left pixels starting at zero the first pixel picks the one above
+    const __m128i zero = _mm_setzero_si128();
+
+    const auto abs16 = [zero](const __m128i x){return _mm_max_epi16(x, _mm_sub_epi16(zero, x));};
+    const auto select = [](const __m128i mask, const __m128i a, const __m128i b)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    };
+
+    __m128i above = zero;
+    __m128i current = zero;
+
+    size_t i = 0;
+    for(; i+bpp <= size; i += bpp)
+    {
+        const __m128i up_left = above;
+        above = _mm_unpacklo_epi8(load_pixel<bpp>(previous+i), zero);
+
+        const __m128i left = current;
+        current = _mm_unpacklo_epi8(load_pixel<bpp>(in+i), zero);
+
+        //distances from left+up-up_left to each of them
+        __m128i distance_left = _mm_sub_epi16(above, up_left);
+        __m128i distance_up = _mm_sub_epi16(left, up_left);
+        __m128i distance_up_left = _mm_add_epi16(distance_left, distance_up);
+
+        distance_left = abs16(distance_left);
+        distance_up = abs16(distance_up);
+        distance_up_left = abs16(distance_up_left);
+
+        const __m128i smallest = _mm_min_epi16(distance_up_left, _mm_min_epi16(distance_left, distance_up));
+
+        //ties go to left, then up
+        const __m128i predicted = select(_mm_cmpeq_epi16(smallest, distance_left), left,
+            select(_mm_cmpeq_epi16(smallest, distance_up), above, up_left));
+
+        //adding bytes keeps the wrap around at 256 and the high halves zero
+        current = _mm_add_epi8(current, predicted);
+        store_pixel<bpp>(out+i, _mm_packus_epi16(current, current));
+    }
+
+    for(; i < size; ++i)
+    {
+        const bool first = i<bpp;
+        out[i] = in[i]+paeth_predictor(first ? 0 : out[i-bpp], previous[i], first ? 0 : previous[i-bpp]);
+    }
+}
+#else
+void png::unfilter_up_sse2(const uint8_t* in, uint8_t* out, const uint8_t* previous, const size_t size) noexcept
+{
+    unfilter_row_scalar<1>(2, in, out, previous, size, 1);
+}
+
+void png::unfilter_up_avx2(const uint8_t* in, uint8_t* out, const uint8_t* previous, const size_t size) noexcept
+{
+    unfilter_row_scalar<1>(2, in, out, previous, size, 1);
+}
+#endif
+
+png::row_filter::row_filter(const size_t size, const uint8_t bpp)
+: _size(size), _bpp(bpp), _lines(5*(size+1)), _zeros(size, 0)
+{
+    for(uint8_t f = 0; f < 5; ++f)
+        _lines[f*(size+1)] = f;
+}
+
+void png::row_filter::filter(const uint8_t* row, const uint8_t* previous, std::array<uint64_t, 5>& sums) noexcept
+{
+    std::array<uint8_t*, 5> out;
+    for(uint8_t f = 0; f < 5; ++f)
+        out[f] = _lines.data()+f*(_size+1)+1;
+
+    filter_candidates(row, previous ? previous : _zeros.data(), out, _size, _bpp, sums);
+}
+
+const uint8_t* png::row_filter::line(const uint8_t filter) const noexcept
+{
+    return _lines.data()+filter*(_size+1);
+}
+
+size_t png::row_filter::line_size() const noexcept
+{
+    return _size+1;
+}
+
+void png::row_filter::filter(const uint8_t filter, const uint8_t* row, const uint8_t* previous) noexcept
+{
+    filter_row(filter, row, previous ? previous : _zeros.data(), _lines.data()+filter*(_size+1)+1, _size, _bpp);
+}
+
+png::filter_selector::filter_selector(const image_view& img, const filter_strategy strategy, ydeflate::deflater& stream)
+: _img(img), _strategy(strategy), _row_size(static_cast<size_t>(img.width)*img.bpp),
+_filter(_row_size, img.bpp), _stream(stream)
+{
+}
+
+const uint8_t* png::filter_selector::line(const unsigned y)
+{
+    const uint8_t* row = _img.row(y);
+    const uint8_t* previous = y==0 ? nullptr : _img.row(y-1);
+
+    switch(_strategy)
+    {
+        case filter_strategy::min_sum:
+        {
+            std::array<uint64_t, 5> sums;
+            _filter.filter(row, previous, sums);
+
+            return _filter.line(smallest_sum(sums));
+        }
+
+        case filter_strategy::entropy:
+        {
+            std::array<uint64_t, 5> sums;
+            _filter.filter(row, previous, sums);
+
+            return _filter.line(smallest_entropy(_filter));
+        }
+
+        case filter_strategy::brute_force:
+        {
+            std::array<uint64_t, 5> sums;
+            _filter.filter(row, previous, sums);
+
+            return _filter.line(smallest_compressed());
+        }
+
+        default:
+        {
+            //the fixed ones line up with the filter types
+            const uint8_t filter_type = static_cast<uint8_t>(_strategy);
+            _filter.filter(filter_type, row, previous);
+
+            return _filter.line(filter_type);
+        }
+    }
+}
+
+size_t png::filter_selector::line_size() const noexcept
+{
+    return _filter.line_size();
+}
+
+uint8_t png::filter_selector::smallest_compressed()
+{
+    const size_t line_size = _filter.line_size();
+
+    uint8_t best = 0;
+    size_t best_bits = SIZE_MAX;
+    for(uint8_t f = 0; f < 5; ++f)
+    {
+        //the stream is left as it was, the picked line gets written into it by the caller
+        const size_t bits = _stream.trial_bits(_filter.line(f), line_size);
+        if(bits<best_bits)
+        {
+            best = f;
+            best_bits = bits;
+        }
+    }
+
+    return best;
+}
+
+float png::line_entropy(const uint8_t* data, const size_t size) noexcept
+{
+    std::array<unsigned, 256> counts{};
+    for(size_t i = 0; i < size; ++i)
+        ++counts[data[i]];
+
+    //size*log2(size) - sum of count*log2(count)
+    float bits = size==0 ? 0 : size*std::log2(static_cast<float>(size));
+    for(const unsigned count : counts)
+    {
+        if(count!=0)
+            bits -= count*std::log2(static_cast<float>(count));
+    }
+
+    return bits;
+}
+
+uint8_t png::smallest_entropy(const row_filter& filter) noexcept
+{
+    uint8_t best = 0;
+    float best_bits = 0;
+    for(uint8_t f = 0; f < 5; ++f)
+    {
+        //without the filter type byte
+        const float bits = line_entropy(filter.line(f)+1, filter.line_size()-1);
+        if(f==0 || bits<best_bits)
+        {
+            best = f;
+            best_bits = bits;
+        }
+    }
+
+    return best;
+}
+
+uint8_t png::smallest_sum(const std::array<uint64_t, 5>& sums) noexcept
+{
+    //ties go to the simpler filter
+    return std::min_element(sums.begin(), sums.end())-sums.begin();
+}
+
+void png::filter_candidates(const uint8_t* row, const uint8_t* previous, const std::array<uint8_t*, 5>& out,
+    const size_t size, const uint8_t bpp, std::array<uint64_t, 5>& sums) noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    filter_candidates_sse2(row, previous, out, size, bpp, sums);
+#else
+    filter_candidates_scalar(row, previous, out, size, bpp, sums);
+#endif
+}
+
+void png::filter_candidates_scalar(const uint8_t* row, const uint8_t* previous, const std::array<uint8_t*, 5>& out,
+    const size_t size, const uint8_t bpp, std::array<uint64_t, 5>& sums) noexcept
+{
+    sums.fill(0);
+    filter_candidates_range(row, previous, out, 0, size, bpp, sums);
+}
+
+void png::filter_row(const uint8_t filter, const uint8_t* row, const uint8_t* previous, uint8_t* out,
+    const size_t size, const uint8_t bpp) noexcept
+{
+    const size_t first = std::min(static_cast<size_t>(bpp), size);
+
+    switch(filter)
+    {
+        default:
+        case 0:
+            std::memcpy(out, row, size);
+            return;
+
+        case 1:
+            std::memcpy(out, row, first);
+            for(size_t i = first; i < size; ++i)
+                out[i] = row[i]-row[i-bpp];
+            return;
+
+        case 2:
+            for(size_t i = 0; i < size; ++i)
+                out[i] = row[i]-previous[i];
+            return;
+
+        case 3:
+            for(size_t i = 0; i < first; ++i)
+                out[i] = row[i]-(previous[i]>>1);
+            for(size_t i = first; i < size; ++i)
+                out[i] = row[i]-((row[i-bpp]+previous[i])>>1);
+            return;
+
+        case 4:
+            for(size_t i = 0; i < first; ++i)
+                out[i] = row[i]-previous[i];
+            for(size_t i = first; i < size; ++i)
+                out[i] = row[i]-paeth_predictor(row[i-bpp], previous[i], previous[i-bpp]);
+            return;
+    }
+}
+
+void png::filter_candidates_range(const uint8_t* row, const uint8_t* previous, const std::array<uint8_t*, 5>& out,
+    const size_t start, const size_t end, const uint8_t bpp, std::array<uint64_t, 5>& sums) noexcept
+{
+    //filtered bytes count as signed, so small negative differences are as good as small positive ones
+    const auto absolute = [](const uint8_t value){return static_cast<unsigned>(std::abs(static_cast<int8_t>(value)));};
+
+    for(size_t i = start; i < end; ++i)
+    {
+        const bool first = i<bpp;
+
+        const int current = row[i];
+        const int left = first ? 0 : row[i-bpp];
+        const int up = previous[i];
+        const int up_left = first ? 0 : previous[i-bpp];
+
+        const uint8_t sub = current-left;
+        const uint8_t up_difference = current-up;
+        const uint8_t average = current-((left+up)>>1);
+        const uint8_t paeth = current-paeth_predictor(left, up, up_left);
+
+        out[0][i] = current;
+        out[1][i] = sub;
+        out[2][i] = up_difference;
+        out[3][i] = average;
+        out[4][i] = paeth;
+
+        sums[0] += absolute(current);
+        sums[1] += absolute(sub);
+        sums[2] += absolute(up_difference);
+        sums[3] += absolute(average);
+        sums[4] += absolute(paeth);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+void png::filter_candidates_sse2(const uint8_t* row, const uint8_t* previous, const std::array<uint8_t*, 5>& out,
+    const size_t size, const uint8_t bpp, std::array<uint64_t, 5>& sums) noexcept
+{
+    sums.fill(0);
+
+    //the first pixel has nothing on the left
+    const size_t first = std::min(static_cast<size_t>(bpp), size);
+    filter_candidates_range(row, previous, out, 0, first, bpp, sums);
+
+    const __m128i zero = _mm_setzero_si128();
+
+    //signed absolute value as an unsigned byte, -128 stays 128
+    const auto absolute = [zero](const __m128i x){return _mm_min_epu8(x, _mm_sub_epi8(zero, x));};
+    const auto abs16 = [zero](const __m128i x){return _mm_max_epi16(x, _mm_sub_epi16(zero, x));};
+    const auto select = [](const __m128i mask, const __m128i a, const __m128i b)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    };
+
+    //same as the unfiltering one, 16 bit lanes so the distances dont overflow
+    const auto paeth_half = [&](const __m128i left, const __m128i above, const __m128i up_left)
+    {
+        __m128i distance_left = _mm_sub_epi16(above, up_left);
+        __m128i distance_up = _mm_sub_epi16(left, up_left);
+        __m128i distance_up_left = _mm_add_epi16(distance_left, distance_up);
+
+        distance_left = abs16(distance_left);
+        distance_up = abs16(distance_up);
+        distance_up_left = abs16(distance_up_left);
+
+        const __m128i smallest = _mm_min_epi16(distance_up_left, _mm_min_epi16(distance_left, distance_up));
+
+        return select(_mm_cmpeq_epi16(smallest, distance_left), left,
+            select(_mm_cmpeq_epi16(smallest, distance_up), above, up_left));
+    };
+
+    __m128i totals[5]{zero, zero, zero, zero, zero};
+
+    const auto add_candidate = [&](const int filter, const size_t i, const __m128i filtered)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out[filter]+i), filtered);
+        totals[filter] = _mm_add_epi64(totals[filter], _mm_sad_epu8(absolute(filtered), zero));
+    };
+
+    //no filter depends on another filtered byte so every lane is independent
+    size_t i = first;
+    for(; i+16 <= size; i += 16)
+    {
+        const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row+i));
+        const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row+i-bpp));
+        const __m128i above = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous+i));
+        const __m128i up_left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous+i-bpp));
+
+        //png averages round down but avg_epu8 rounds up
+        __m128i average = _mm_avg_epu8(left, above);
+        average = _mm_sub_epi8(average, _mm_and_si128(_mm_xor_si128(left, above), _mm_set1_epi8(1)));
+
+        const __m128i paeth_low = paeth_half(_mm_unpacklo_epi8(left, zero), _mm_unpacklo_epi8(above, zero),
+            _mm_unpacklo_epi8(up_left, zero));
+        const __m128i paeth_high = paeth_half(_mm_unpackhi_epi8(left, zero), _mm_unpackhi_epi8(above, zero),
+            _mm_unpackhi_epi8(up_left, zero));
+
+        add_candidate(0, i, current);
+        add_candidate(1, i, _mm_sub_epi8(current, left));
+        add_candidate(2, i, _mm_sub_epi8(current, above));
+        add_candidate(3, i, _mm_sub_epi8(current, average));
+        add_candidate(4, i, _mm_sub_epi8(current, _mm_packus_epi16(paeth_low, paeth_high)));
+    }
+
+    filter_candidates_range(row, previous, out, i, size, bpp, sums);
+
+    for(int f = 0; f < 5; ++f)
+    {
+        std::array<uint64_t, 2> halves;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(halves.data()), totals[f]);
+
+        sums[f] += halves[0]+halves[1];
+    }
+}
+#else
+void png::filter_candidates_sse2(const uint8_t* row, const uint8_t* previous, const std::array<uint8_t*, 5>& out,
+    const size_t size, const uint8_t bpp, std::array<uint64_t, 5>& sums) noexcept
+{
+    filter_candidates_scalar(row, previous, out, size, bpp, sums);
+}
+#endif
+
+uint32_t png::crc32(const uint32_t crc, const uint8_t* data, const size_t size) noexcept
+{
+    typedef uint32_t (*crc_func)(uint32_t, const uint8_t*, size_t);
+
+#if defined(__x86_64__) || defined(__i386__)
+    static const crc_func best_crc = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1")
+        ? crc32_clmul : crc32_slicing;
+#else
+    static const crc_func best_crc = crc32_slicing;
+#endif
+
+    return best_crc(crc, data, size);
+}
+
+uint32_t png::crc32_slicing(uint32_t crc, const uint8_t* data, size_t size) noexcept
+{
+    static constexpr std::array<std::array<uint32_t, 256>, 8> crc_tables = crc_table_gen();
+
+    crc = ~crc;
+
+    //8 bytes go through 8 table lookups that dont depend on each other
+    for(; size>=8; data += 8, size -= 8)
+    {
+        const uint32_t low = (data[0]|(data[1]<<8)|(data[2]<<16)|(static_cast<uint32_t>(data[3])<<24))^crc;
+        const uint32_t high = data[4]|(data[5]<<8)|(data[6]<<16)|(static_cast<uint32_t>(data[7])<<24);
+
+        crc = crc_tables[7][low&0xff]^crc_tables[6][(low>>8)&0xff]
+            ^crc_tables[5][(low>>16)&0xff]^crc_tables[4][low>>24]
+            ^crc_tables[3][high&0xff]^crc_tables[2][(high>>8)&0xff]
+            ^crc_tables[1][(high>>16)&0xff]^crc_tables[0][high>>24];
+    }
+
+    for(; size!=0; ++data, --size)
+        crc = crc_tables[0][(crc^*data)&0xff]^(crc>>8);
+
+    return ~crc;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("pclmul,sse4.1")))
+uint32_t png::crc32_clmul(uint32_t crc, const uint8_t* data, size_t size) noexcept
+{
+    //folds 64 bytes at a time with carry-less multiplies, from intels
+    //"fast crc computation for generic polynomials using pclmulqdq" paper
+    if(size<64)
+        return crc32_slicing(crc, data, size);
+
+    //x^(4*128+32) mod p, x^(4*128-32) mod p and so on, bit reflected
+    alignas(16) static constexpr uint64_t k1k2[2] = {0x0154442bd4, 0x01c6e41596};
+    alignas(16) static constexpr uint64_t k3k4[2] = {0x01751997d0, 0x00ccaa009e};
+    alignas(16) static constexpr uint64_t k5k0[2] = {0x0163cd6124, 0x0000000000};
+    //the polynomial and its barrett reduction constant
+    alignas(16) static constexpr uint64_t poly[2] = {0x01db710641, 0x01f7011641};
+
+    const size_t tail_size = size&15;
+    size -= tail_size;
+
+    __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data+16));
+    __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data+32));
+    __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data+48));
+
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(~crc));
+
+    __m128i k = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+
+    data += 64;
+    size -= 64;
+
+    const auto fold = [&k](const __m128i x, const __m128i next) __attribute__((target("pclmul,sse4.1")))
+    {
+        const __m128i low = _mm_clmulepi64_si128(x, k, 0x00);
+        const __m128i high = _mm_clmulepi64_si128(x, k, 0x11);
+
+        return _mm_xor_si128(_mm_xor_si128(low, high), next);
+    };
+
+    for(; size>=64; data += 64, size -= 64)
+    {
+        x1 = fold(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+        x2 = fold(x2, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data+16)));
+        x3 = fold(x3, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data+32)));
+        x4 = fold(x4, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data+48)));
+    }
+
+    //four lanes into one
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+
+    x1 = fold(x1, x2);
+    x1 = fold(x1, x3);
+    x1 = fold(x1, x4);
+
+    for(; size>=16; data += 16, size -= 16)
+        x1 = fold(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+
+    //128 bits down to 64
+    const __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+    k = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    //barrett reduction to 32 bits
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    crc = ~static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+
+    return crc32_slicing(crc, data, tail_size);
+}
+#else
+uint32_t png::crc32_clmul(uint32_t crc, const uint8_t* data, size_t size) noexcept
+{
+    return crc32_slicing(crc, data, size);
+}
+#endif
+
+uint8_t png::paeth_predictor(const int left, const int up, const int up_left) noexcept
+{
+    const int initial_est = left + up - up_left;
+
+    const int distance_left = std::abs(initial_est - left);
+    const int distance_up = std::abs(initial_est - up);
+    const int distance_up_left = std::abs(initial_est - up_left);
+
+    if((distance_left<=distance_up) && (distance_left<=distance_up_left))
+    {
+        return left;
+    } else if(distance_up<=distance_up_left)
+    {
+        return up;
+    } else
+    {
+        return up_left;
+    }
+}
+
+image pgm::read(const std::filesystem::path load_path)
+{
+    //im not parsing comments because NO
+    std::ifstream read_stream(load_path, std::ios::binary);
+
+    std::array<char, 2> data_type;
+    read_stream.read(data_type.data(), 2);
+
+    image img;
+    if(strncmp(data_type.data(), "P2", 2)==0||strncmp(data_type.data(), "P5", 2)==0)
+    {
+        std::string width_string;
+        read_stream >> width_string;
+        img.width = std::stoul(width_string);
+
+        std::string height_string;
+        read_stream >> height_string;
+        img.height = std::stoul(height_string);
+
+        const int image_size = img.width*img.height;
+        img.data.reserve(image_size);
+
+        std::string max_val_string;
+        read_stream >> max_val_string;
+        const float max_val = std::stof(max_val_string);
+
+        if(strncmp(data_type.data(), "P2", 2)==0)
+        {
+            //ascii
+            for(int i = 0; i < image_size; ++i)
+            {
+                std::string color_string;
+                read_stream >> color_string;
+
+                img.data.emplace_back(std::round(255*(std::stoi(color_string)/max_val)));
+            }
+        } else
+        {
+            //binary
+            for(int i = 0; i < image_size; ++i)
+            {
+                img.data.emplace_back(std::round(255*(read_stream.get()/max_val)));
+            }
+        }
+    } else
+    {
+        throw std::runtime_error("pgm::read wrong magic numbers");
+    }
+
+    img.bpp = 1;
+
+    return img;
+}
+
+image_info pgm::probe(const std::filesystem::path load_path)
+{
+    std::ifstream read_stream(load_path, std::ios::binary);
+
+    std::array<char, 2> data_type;
+    read_stream.read(data_type.data(), 2);
+
+    if(strncmp(data_type.data(), "P2", 2)!=0 && strncmp(data_type.data(), "P5", 2)!=0)
+        throw std::runtime_error("pgm::read wrong magic numbers");
+
+    std::string width_string;
+    std::string height_string;
+    std::string max_val_string;
+    read_stream >> width_string >> height_string >> max_val_string;
+
+    image_info info;
+    info.width = std::stoul(width_string);
+    info.height = std::stoul(height_string);
+    info.channels = 1;
+    info.bit_depth = std::stoul(max_val_string)>255 ? 16 : 8;
+
+    return info;
+}
+
+void pgm::save(const image_view& img, const std::filesystem::path save_path)
+{
+    if(img.bpp!=1)
+        return;
+
+    std::ofstream out_stream(save_path, std::ios::binary);
+
+    std::vector<char> image_header;
+    //magic number for the binary grayscale format
+    image_header.push_back('P');
+    image_header.push_back('5');
+
+    image_header.push_back('\n');
+
+    const std::string width_string = std::to_string(img.width);
+    image_header.insert(image_header.end(), width_string.begin(), width_string.end());
+
+    image_header.push_back('\n');
+
+    const std::string height_string = std::to_string(img.height);
+    image_header.insert(image_header.end(), height_string.begin(), height_string.end());
+
+    image_header.push_back('\n');
+
+    //max value for a color which is 255
+    image_header.push_back('2');
+    image_header.push_back('5');
+    image_header.push_back('5');
+
+    image_header.push_back('\n');
+
+    out_stream.write(image_header.data(), image_header.size());
+
+
+    //rows straight from the view, they might not be next to each other
+    for(unsigned y = 0; y < img.height; ++y)
+        out_stream.write(reinterpret_cast<const char*>(img.row(y)), img.row_size());
+}
+
+void ppm::save(const image_view& img, const std::filesystem::path save_path)
+{
+    if(img.bpp!=3)
+        return;
+
+    std::ofstream out_stream(save_path, std::ios::binary);
+
+    std::vector<char> image_header;
+    //magic number for the binary rgb format
+    image_header.push_back('P');
+    image_header.push_back('6');
+
+    image_header.push_back('\n');
+
+    const std::string width_string = std::to_string(img.width);
+    image_header.insert(image_header.end(), width_string.begin(), width_string.end());
+
+    image_header.push_back('\n');
+
+    const std::string height_string = std::to_string(img.height);
+    image_header.insert(image_header.end(), height_string.begin(), height_string.end());
+
+    image_header.push_back('\n');
+
+    //max value for a color which is 255
+    image_header.push_back('2');
+    image_header.push_back('5');
+    image_header.push_back('5');
+
+    image_header.push_back('\n');
+
+    out_stream.write(image_header.data(), image_header.size());
+
+
+    //rows straight from the view, they might not be next to each other
+    for(unsigned y = 0; y < img.height; ++y)
+        out_stream.write(reinterpret_cast<const char*>(img.row(y)), img.row_size());
+}
+
+std::vector<uint8_t> ydeflate::deflate(const std::vector<uint8_t>& input_data, const bool verify)
+{
+    std::vector<uint8_t> deflated_data;
+
+    if(input_data.size()<2)
+        return deflated_data;
+
+    const uint8_t compression_info = (input_data[0]>>4);
+    const uint8_t compression_method = (input_data[0]&0x0f);
+
+    if(compression_method!=8 | compression_info>7)
+    {
+        //all deflate streams have 8 compression method (at the moment)
+        return deflated_data;
+    }
+
+    const std::array<char, 4> checksum_str = {
+        static_cast<char>(input_data[0]),
+        static_cast<char>(input_data[1]), 0, 0};
+
+    const unsigned checksum_num = chars_to_number<unsigned>(checksum_str.data());;
+
+    if(checksum_num%31!=0)
+    {
+        //the checksum is just the 2 bytes being divisible by 31
+        return deflated_data;
+    }
+
+    //stored blocks only get copied, no need to guess the size
+    std::vector<span> payload;
+    uint32_t payload_checksum;
+    if(stored_payload({{input_data.data(), input_data.size()}}, payload, payload_checksum))
+    {
+        size_t payload_size = 0;
+        for(const span& part : payload)
+            payload_size += part.size;
+
+        deflated_data.resize(payload_size);
+        copy_payload(payload, payload_checksum, deflated_data.data(), payload_size, verify);
+
+        return deflated_data;
+    }
+
+    inflater stream(verify);
+    stream.feed(input_data.data(), input_data.size(), true);
+
+    size_t data_size = 0;
+    while(!stream.finished())
+    {
+        deflated_data.resize(std::max(data_size*2, input_data.size()*4));
+        data_size += stream.read(deflated_data.data()+data_size, deflated_data.size()-data_size);
+    }
+
+    deflated_data.resize(data_size);
+
+    return deflated_data;
+}
+
+size_t ydeflate::deflate(const uint8_t* input_data, const size_t input_size, uint8_t* out, const size_t out_size,
+    const bool verify)
+{
+    std::vector<span> payload;
+    uint32_t payload_checksum;
+    if(stored_payload({{input_data, input_size}}, payload, payload_checksum))
+        return copy_payload(payload, payload_checksum, out, out_size, verify);
+
+    inflater stream(verify);
+    stream.feed(input_data, input_size, true);
+
+    return stream.read_all(out, out_size);
+}
+
+bool ydeflate::stored_payload(const std::vector<span>& input, std::vector<span>& payload, uint32_t& checksum)
+{
+    payload.clear();
+
+    size_t index = 0;
+    size_t offset = 0;
+
+    //false at the end of the input
+    const auto next_byte = [&](uint8_t& value) -> bool
+    {
+        while(index<input.size() && offset==input[index].size)
+        {
+            ++index;
+            offset = 0;
+        }
+
+        if(index==input.size())
+            return false;
+
+        value = input[index].data[offset++];
+        return true;
+    };
+
+    const auto next_bytes = [&](uint8_t* values, const int num) -> bool
+    {
+        for(int i = 0; i < num; ++i)
+        {
+            if(!next_byte(values[i]))
+                return false;
+        }
+
+        return true;
+    };
+
+    std::array<uint8_t, 4> values;
+
+    if(!next_bytes(values.data(), 2))
+        return false;
+
+    const uint8_t cmf_data = values[0];
+    const uint8_t flg_data = values[1];
+    if((cmf_data&0x0f)!=8 || (cmf_data>>4)>7 || (cmf_data*256+flg_data)%31!=0 || (flg_data>>5)&0x1)
+        return false;
+
+    bool last_block = false;
+    while(!last_block)
+    {
+        //stored blocks end byte aligned so the next header always starts on a byte
+        uint8_t block_header;
+        if(!next_byte(block_header) || ((block_header>>1)&0x3)!=0)
+            return false;
+
+        last_block = block_header&0x1;
+
+        if(!next_bytes(values.data(), 4))
+            return false;
+
+        size_t length = values[0]|(values[1]<<8);
+        const unsigned length_complement = values[2]|(values[3]<<8);
+
+        if((length^length_complement)!=0xffff)
+            return false;
+
+        //the block can go over several parts of the input
+        while(length!=0)
+        {
+            while(index<input.size() && offset==input[index].size)
+            {
+                ++index;
+                offset = 0;
+            }
+
+            if(index==input.size())
+                return false;
+
+            const size_t part_size = std::min(length, input[index].size-offset);
+
+            //blocks that continue in the same buffer join together
+            if(!payload.empty() && payload.back().data+payload.back().size==input[index].data+offset)
+            {
+                payload.back().size += part_size;
+            } else
+            {
+                payload.push_back({input[index].data+offset, part_size});
+            }
+
+            offset += part_size;
+            length -= part_size;
+        }
+    }
+
+    if(!next_bytes(values.data(), 4))
+        return false;
+
+    checksum = (static_cast<uint32_t>(values[0])<<24)|(values[1]<<16)|(values[2]<<8)|values[3];
+
+    return true;
+}
+
+size_t ydeflate::copy_payload(const std::vector<span>& payload, const uint32_t checksum, uint8_t* out,
+    const size_t out_size, const bool verify)
+{
+    size_t out_end = 0;
+    uint32_t adler = 1;
+
+    for(const span& part : payload)
+    {
+        if(part.size>out_size-out_end)
+            throw std::runtime_error("deflate output is larger than the buffer");
+
+        std::memcpy(out+out_end, part.data, part.size);
+        out_end += part.size;
+
+        if(verify)
+            adler = adler32(adler, part.data, part.size);
+    }
+
+    if(verify && adler!=checksum)
+        throw std::runtime_error("zlib adler32 checksum doesnt match");
+
+    return out_end;
+}
+
+ydeflate::inflater::inflater(const bool verify)
+: _verify(verify), _window(max_distance*4)
+{
+}
+
+void ydeflate::inflater::feed(const uint8_t* data, const size_t size, const bool last_input)
+{
+    _last_input = last_input;
+    _needs_input = false;
+
+    //unread bytes of the previous input go first, usually just a few leftover ones
+    std::vector<uint8_t> leftover;
+    _reader.take_remaining(leftover);
+
+    _carry = std::move(leftover);
+    _reader.set_input(_carry.data(), _carry.size(), data, size);
+}
+
+size_t ydeflate::inflater::read(uint8_t* out, const size_t size)
+{
+    size_t written = 0;
+    while(true)
+    {
+        const size_t pending = std::min(_window_end-_window_read, size-written);
+        std::memcpy(out+written, _window.data()+_window_read, pending);
+
+        _window_read += pending;
+        written += pending;
+
+        if(written==size || _state==state::finished || _needs_input)
+            break;
+
+        if(_window_end+max_length>=_window.size())
+        {
+            //everything was read out so only the history matters
+            std::memmove(_window.data(), _window.data()+_window_end-max_distance, max_distance);
+            _window_end = max_distance;
+            _window_read = max_distance;
+        }
+
+        const size_t previous_end = _window_end;
+
+        step(_window.data(), _window_end, _window.size()-max_length, _window.size());
+
+        if(_verify)
+            _adler = adler32(_adler, _window.data()+previous_end, _window_end-previous_end);
+    }
+
+    return written;
+}
+
+size_t ydeflate::inflater::read_all(uint8_t* out, const size_t size)
+{
+    size_t out_end = 0;
+    while(_state!=state::finished)
+    {
+        if(_needs_input)
+            throw std::runtime_error("inflater::read_all needs the whole stream fed");
+
+        const size_t previous_end = out_end;
+        const state previous_state = _state;
+
+        step(out, out_end, size, size);
+
+        if(_verify)
+            _adler = adler32(_adler, out+previous_end, out_end-previous_end);
+
+        const bool decoding = _state==state::codes || _state==state::uncompressed;
+        if(decoding && previous_state==_state && previous_end==out_end)
+            throw std::runtime_error("deflate output is larger than the buffer");
+    }
+
+    return out_end;
+}
+
+bool ydeflate::inflater::needs_input() const noexcept
+{
+    return _needs_input;
+}
+
+bool ydeflate::inflater::finished() const noexcept
+{
+    return _state==state::finished;
+}
+
+void ydeflate::inflater::step(uint8_t* out, size_t& out_end, const size_t out_limit, const size_t out_size)
+{
+    switch(_state)
+    {
+        case state::zlib_header:
+        {
+            if(!enough_input(16))
+                return;
+
+            const uint8_t cmf_data = _reader.read(8);
+            const uint8_t flg_data = _reader.read(8);
+
+            if((cmf_data&0x0f)!=8 || (cmf_data>>4)>7 || (cmf_data*256+flg_data)%31!=0)
+                throw std::runtime_error("invalid zlib header");
+
+            if((flg_data>>5)&0x1)
+                throw std::runtime_error("zlib preset dictionaries arent supported");
+
+            _state = state::block_header;
+            return;
+        }
+
+        case state::block_header:
+        {
+            if(_last_block)
+            {
+                _state = state::checksum;
+                return;
+            }
+
+            if(!enough_input(3))
+                return;
+
+            //00 - no compression
+            //01 - compressed with fixed huffman codes
+            //10 - compressed with dynamic huffman codes
+            //11 - error
+            const uint8_t compression_type = (_reader.peek(3)>>1)&0x3;
+            if(!enough_input(compression_type==2 ? max_dynamic_header_bits : max_symbol_bits))
+                return;
+
+            _last_block = _reader.read(1);
+            _reader.consume(2);
+
+            switch(compression_type)
+            {
+                case 0:
+                {
+                    _reader.align_byte(); //skip the partial bytes
+
+                    _uncompressed_left = _reader.read(16);
+                    const unsigned length_complement = _reader.read(16);
+
+                    if((_uncompressed_left^length_complement)!=0xffff)
+                        throw std::runtime_error("deflate stored block length mismatch");
+
+                    _state = state::uncompressed;
+                    break;
+                }
+
+                case 1:
+                    static_huffman_tables(_literals, _distances);
+                    _state = state::codes;
+                break;
+
+                case 2:
+                    dynamic_huffman_tables(_reader, _literals, _distances);
+                    _state = state::codes;
+                break;
+
+                case 3:
+                default:
+                    throw std::runtime_error("invalid deflate block type");
+            }
+
+            if(_reader.overrun())
+                throw std::runtime_error("deflate stream is truncated");
+
+            return;
+        }
+
+        case state::uncompressed:
+        {
+            if(_uncompressed_left==0)
+            {
+                _state = state::block_header;
+                return;
+            }
+
+            const size_t available = _reader.available_bits()/8;
+            if(available==0)
+            {
+                if(_last_input)
+                    throw std::runtime_error("deflate stream is truncated");
+
+                enough_input(8);
+                return;
+            }
+
+            const size_t copy_size = std::min({static_cast<size_t>(_uncompressed_left),
+                available, out_size-out_end});
+
+            _reader.read_bytes(out+out_end, copy_size);
+
+            out_end += copy_size;
+            _uncompressed_left -= copy_size;
+            return;
+        }
+
+        case state::codes:
+            out_end = decode_codes(out, out_end, out_limit, out_size);
+            return;
+
+        case state::checksum:
+        {
+            _reader.align_byte();
 
-            const int params_size = params.size();
+            if(!enough_input(32))
+                return;
 
-            if(params[params_size-1].length()==0)
+            //the data is already out so a missing checksum isnt worth failing over
+            //unless its being verified
+            if(_reader.available_bits()>=32)
             {
-                params.pop_back();
-            }
+                const uint32_t stored = _reader.read(32);
 
-            std::vector<int> order = {0, 1, 2};
+                //stored big endian
+                const uint32_t adler = (stored>>24)|((stored>>8)&0xff00)|((stored<<8)&0xff0000)|(stored<<24);
 
-            if(params_size>3)
+                if(_verify && adler!=_adler)
+                    throw std::runtime_error("zlib adler32 checksum doesnt match");
+            } else if(_verify)
             {
-                for(int i = 3; i < params_size; i++)
-                {
-                    order.push_back(0);
-                    order.push_back(i-1);
-                    order.push_back(i);
-                }
+                throw std::runtime_error("zlib adler32 checksum is missing");
             }
 
-            for(const auto& p : order)
-            {
-                const auto find_index = std::find(saved_params.begin(), saved_params.end(), params[p]);
+            _state = state::finished;
+            return;
+        }
 
-                if(find_index!=saved_params.end())
-                {
-                    repeated_verts.push_back(vert_indices.size()-std::distance(saved_params.begin(), find_index));
-                } else
-                {
-                    repeated_verts.push_back(0);
-                }
+        case state::finished:
+            return;
+    }
+}
 
-                saved_params.push_back(params[p]);
+bool ydeflate::inflater::enough_input(const size_t bits) noexcept
+{
+    //the final chunk cant get more input, it reads zeros past the end instead
+    if(_last_input || _reader.available_bits()>=bits)
+        return true;
 
-                const std::vector<std::string> face_vals = string_split(params[p], "/");
+    //move the unread bytes out of the fed data before the caller reuses it
+    std::vector<uint8_t> leftover;
+    _reader.take_remaining(leftover);
 
-                vert_indices.push_back(std::stoi(face_vals[0])-1);
+    _carry = std::move(leftover);
+    _reader.set_input(_carry.data(), _carry.size());
 
-                if(face_vals.size()>=2 && face_vals[1].length()!=0)
-                {
-                    uv_indices.push_back(std::stoi(face_vals[1])-1);
-                } else
-                {
-                    uv_indices.push_back(UINT_MAX);
-                }
+    _needs_input = true;
+    return false;
+}
 
-                if(face_vals.size()==3)
-                {
-                    normal_indices.push_back(std::stoi(face_vals[2])-1);
-                } else
-                {
-                    normal_indices.push_back(UINT_MAX);
-                }
-            }
+size_t ydeflate::inflater::decode_codes(uint8_t* out, size_t out_pos, const size_t out_limit, const size_t out_size)
+{
+    while(out_pos<=out_limit)
+    {
+        if(!enough_input(max_symbol_bits))
+            break;
+
+        const int code_index = _literals.decode(_reader);
+
+        if(code_index<0)
+            throw std::runtime_error("invalid deflate huffman code");
+
+        if(code_index<256)
+        {
+            if(out_pos==out_size)
+                throw std::runtime_error("deflate output is larger than the buffer");
+
+            out[out_pos++] = static_cast<uint8_t>(code_index);
+        } else if(code_index==256)
+        {
+            _state = state::block_header;
+            break;
         } else
         {
-            //std::cout << c_model_line << std::endl;
-        }
-    }
+            const int read_length = huffman_length(_reader, code_index);
 
-    int indexing_offset = 0;
+            const int distance_index = _distances.decode(_reader);
+            if(distance_index<0)
+                throw std::runtime_error("invalid deflate huffman code");
 
-    for(int v = 0; v < vert_indices.size(); v++)
-    {
-        if(repeated_verts[v]==0)
-        {
-            vertices.push_back(c_verts[vert_indices[v]*3]);
-            vertices.push_back(c_verts[vert_indices[v]*3+1]);
-            vertices.push_back(c_verts[vert_indices[v]*3+2]);
+            const int read_distance = huffman_distance(_reader, distance_index);
 
-            indices.push_back(v-indexing_offset);
+            if(static_cast<size_t>(read_distance)>out_pos)
+                throw std::runtime_error("deflate distance too far back");
 
-            if(uv_indices[v]!=UINT_MAX)
+            if(out_pos+read_length>out_size)
+                throw std::runtime_error("deflate output is larger than the buffer");
+
+            if(out_pos+read_length+copy_slack<=out_size)
             {
-                vertices.push_back(c_uvs[uv_indices[v]*2]);
-                vertices.push_back(c_uvs[uv_indices[v]*2+1]);
+                copy_match(out+out_pos, read_distance, read_length);
             } else
             {
-                vertices.push_back(0);
-                vertices.push_back(0);
+                for(int rb = 0; rb < read_length; ++rb)
+                    out[out_pos+rb] = out[out_pos+rb-read_distance];
             }
-        } else
-        {
-            indices.push_back(indices[v-repeated_verts[v]]);
-            indexing_offset++;
+
+            out_pos += read_length;
         }
+
+        //past the end the reader gives zeros which could decode forever
+        if(_reader.overrun())
+            throw std::runtime_error("deflate stream is truncated");
     }
 
-    return true;
+    return out_pos;
 }
 
-image png::read(const std::filesystem::path load_path)
+void ydeflate::copy_match(uint8_t* out, const size_t distance, const size_t length) noexcept
 {
-    std::ifstream input_stream(load_path, std::ios::binary);
+    const uint8_t* source = out-distance;
 
-    //PNG files begin with 89 50 4e 47 0d 0a 1a 0a
-    input_stream.seekg(8, std::ios_base::beg);
-
-    uint8_t bit_depth;
-    uint8_t values_per_pixel;
+    if(distance==1)
+    {
+        //a run of one byte
+        std::memset(out, *source, length);
+        return;
+    }
 
-    bool pallete_used;
-    bool rgb_used;
-    bool alpha_channel;
+    if(distance>=16)
+    {
+        //the source is always at least a whole copy behind so overlapping is fine
+        for(size_t i = 0; i < length; i += 16)
+            std::memcpy(out+i, source+i, 16);
 
-    uint8_t vals_per_byte;
+        return;
+    }
 
-    bool interlacing;
+    if(distance>=8)
+    {
+        for(size_t i = 0; i < length; i += 8)
+            std::memcpy(out+i, source+i, 8);
 
-    std::vector<uint8_t> deflate_stream;
+        return;
+    }
 
-    std::vector<uint8_t> pallete_vector;
+    //short distances repeat a pattern, write it out until it covers 8 bytes
+    //and then copy 8 bytes at a time from a whole number of periods back
+    const size_t period = distance*((8+distance-1)/distance);
 
-    std::vector<uint8_t> temp_data;
-    unsigned temp_width = 0;
-    unsigned temp_height = 0;
+    size_t i = 0;
+    for(; i < period && i < length; ++i)
+        out[i] = source[i];
 
-    image img;
-    while(input_stream.good())
-    {
-        //this is definitely not proper c++
-        //THIS ISNT EVEN PROPER PROGRAMMING
-        std::array<char, 4> chunk_length_str;
-        input_stream.read(chunk_length_str.data(), 4);
+    for(; i < length; i += 8)
+        std::memcpy(out+i, out+i-period, 8);
+}
 
-        const unsigned chunk_length = ydeflate::chars_to_number<unsigned>(chunk_length_str.data());
+void ydeflate::static_huffman_tables(huffman_table& literals, huffman_table& distances)
+{
+    //fixed codes from the deflate spec, same for every block so build them once
+    static const huffman_table literals_table(
+        std::vector<int>(fixed_literal_lengths.begin(), fixed_literal_lengths.end()), 9);
 
-        std::array<char, 4> chunk_type;
-        input_stream.read(chunk_type.data(), 4);
+    static const huffman_table distance_table(
+        std::vector<int>(fixed_distance_lengths.begin(), fixed_distance_lengths.end()), 5);
 
-        std::vector<char> chunk_data(chunk_length); //char is always 1 byte long
-        input_stream.read(chunk_data.data(), chunk_length);
+    literals = literals_table;
+    distances = distance_table;
+}
 
-        std::array<char, 4> chunk_checksum;
-        input_stream.read(chunk_checksum.data(), 4);
+void ydeflate::dynamic_huffman_tables(bit_reader& reader, huffman_table& literals, huffman_table& distances)
+{
+    const int codes_length_total = reader.read(5) + 257;
+    const int codes_distance_total = reader.read(5) + 1;
 
-        //could do the checksum here if ur cool
+    const int code_length = reader.read(4) + 4;
 
-        if(strncmp(chunk_type.data(), "IHDR", 4)==0)
-        {
-            std::array<char, 4> image_width_str;
-            std::array<char, 4> image_height_str;
-            for(int i = 0; i < 4; i++)
-            {
-                image_width_str[i] = chunk_data[i];
-                image_height_str[i] = chunk_data[i+4];
-            }
-            temp_width = ydeflate::chars_to_number<unsigned>(image_width_str.data());
-            temp_height = ydeflate::chars_to_number<unsigned>(image_height_str.data());
+    //code length codes are stored in this order
+    const std::array<uint8_t, 19> length_codes_order{16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
 
-            bit_depth = static_cast<uint8_t>(chunk_data[8]);
-            const uint8_t color_type = static_cast<uint8_t>(chunk_data[9]);
+    std::vector<int> length_codes_vec(19, 0);
+    for(int lc = 0; lc < code_length; ++lc)
+        length_codes_vec[length_codes_order[lc]] = reader.read(3);
 
-            pallete_used = color_type&0x1;
-            rgb_used = (color_type>>1)&0x1;
-            alpha_channel = (color_type>>2)&0x1;
+    const huffman_table length_codes_table(length_codes_vec, 7);
 
-            values_per_pixel = (2*rgb_used)+alpha_channel+1;
+    //literal and distance lengths are one sequence, repeats can cross between them
+    const size_t codes_total = codes_length_total+codes_distance_total;
 
-            img.bpp = std::ceil((values_per_pixel*bit_depth)/8.0f);
-            vals_per_byte = 8/bit_depth;
+    std::vector<int> codewords_vec;
+    codewords_vec.reserve(codes_total);
+    while(codewords_vec.size()<codes_total)
+    {
+        const int code_index = length_codes_table.decode(reader);
 
-            interlacing = static_cast<bool>(chunk_data[12]);
-        } else if(strncmp(chunk_type.data(), "IDAT", 4)==0)
+        if(code_index<0)
         {
-            deflate_stream.reserve(chunk_length);
-            for(int i = 0; i < chunk_length; i++)
-            {
-                deflate_stream.push_back(chunk_data[i]);
-            }
-        } else if(strncmp(chunk_type.data(), "PLTE", 4)==0)
+            throw std::runtime_error("invalid deflate code length code");
+        } else if(code_index<16)
+        {
+            //code length 0-15
+            codewords_vec.push_back(code_index);
+        } else if(code_index==16)
         {
-            if(chunk_length%3!=0)
-                throw std::runtime_error("PLTE chunk length is not a multiple of 3");
+            //this code reads previous code length 3-6 times (2 extra bits to read)
+            if(codewords_vec.empty())
+                throw std::runtime_error("deflate length repeat without previous length");
 
-            pallete_vector.reserve(chunk_length);
-            for(int i = 0; i < chunk_length; i++)
-            {
-                pallete_vector.emplace_back(chunk_data[i]);
-            }
-        } else if(strncmp(chunk_type.data(), "IEND", 4)==0)
+            const int read_length = reader.read(2) + 3;
+            codewords_vec.insert(codewords_vec.end(), read_length, codewords_vec.back());
+        } else if(code_index==17)
         {
-            std::vector<uint8_t> image_data = ydeflate::deflate(deflate_stream);
-            if(image_data.size()!=0)
-            {
-                temp_data.reserve(std::ceil(temp_width*temp_height*values_per_pixel/static_cast<float>(vals_per_byte)));
+            //this code copies 0 code 3-10 times (3 extra bits to read)
+            const int read_length = reader.read(3) + 3;
+            codewords_vec.insert(codewords_vec.end(), read_length, 0);
+        } else
+        {
+            //this code copies 0 code 11-138 times (7 extra bits to read)
+            const int read_length = reader.read(7) + 11;
+            codewords_vec.insert(codewords_vec.end(), read_length, 0);
+        }
 
-                unsigned stream_pos = 0;
+        if(reader.overrun())
+            throw std::runtime_error("deflate stream is truncated");
+    }
 
-                for(int y = 0; y < temp_height; ++y)
-                {
-                    const uint8_t filter_type = image_data[stream_pos++];
+    if(codewords_vec.size()!=codes_total)
+        throw std::runtime_error("deflate code lengths overflow");
 
-                    if(pallete_used)
-                    {
-                        for(int x = 0; x < temp_width; ++x, ++stream_pos)
-                        {
-                            const unsigned pallete_pixel = image_data[stream_pos]*3;
-                            temp_data.emplace_back(pallete_vector[pallete_pixel]);
-                            temp_data.emplace_back(pallete_vector[pallete_pixel+1]);
-                            temp_data.emplace_back(pallete_vector[pallete_pixel+2]);
-                        }
-                    } else
-                    {
-                        for(int x = 0; x < temp_width; ++x)
-                        {
-                            for(uint8_t b = 0; b < values_per_pixel; ++b, ++stream_pos)
-                            {
-                                temp_data.emplace_back(defilter_value(temp_data, filter_type, image_data[stream_pos],
-                                    filter_values{static_cast<unsigned>(temp_data.size()), temp_width, x, y, img.bpp}));
-                            }
-                        }
-                    }
-                }
-            }
+    literals = huffman_table(
+        std::vector<int>(codewords_vec.begin(), codewords_vec.begin()+codes_length_total), 9);
+
+    distances = huffman_table(
+        std::vector<int>(codewords_vec.begin()+codes_length_total, codewords_vec.end()), 6);
+}
+
+ydeflate::huffman_table::huffman_table(const std::vector<int>& lengths_vec, const uint8_t primary_bits)
+: _primary_bits(primary_bits)
+{
+    const std::vector<int> codes_vec = lengths_to_prefix(lengths_vec).vec;
 
+    const unsigned primary_size = 1<<primary_bits;
+    const unsigned primary_mask = primary_size-1;
 
-            img.data = std::move(temp_data);
-            img.width = temp_width;
-            img.height = temp_height;
+    //find how many bits each sub-table needs
+    std::vector<uint8_t> sub_bits(primary_size, 0);
 
-            break;
+    const int lengths_size = lengths_vec.size();
+    for(int i = 0; i < lengths_size; ++i)
+    {
+        const int c_length = lengths_vec[i];
+        if(c_length>primary_bits)
+        {
+            const unsigned prefix = reverse_bits(codes_vec[i], c_length)&primary_mask;
+            sub_bits[prefix] = std::max(sub_bits[prefix], static_cast<uint8_t>(c_length-primary_bits));
         }
     }
 
-    return img;
+    _entries.resize(primary_size, 0);
+    for(unsigned p = 0; p < primary_size; ++p)
+    {
+        if(sub_bits[p]!=0)
+        {
+            _entries[p] = (_entries.size()<<16)|0x100|sub_bits[p];
+            _entries.resize(_entries.size()+(1<<sub_bits[p]), 0);
+        }
+    }
+
+    for(int i = 0; i < lengths_size; ++i)
+    {
+        const int c_length = lengths_vec[i];
+        if(c_length==0)
+            continue;
+
+        const unsigned reversed = reverse_bits(codes_vec[i], c_length);
+        if(c_length<=primary_bits)
+        {
+            //every index that starts with this code maps to it
+            for(unsigned index = reversed; index < primary_size; index += 1<<c_length)
+                _entries[index] = (i<<16)|c_length;
+        } else
+        {
+            const uint32_t link = _entries[reversed&primary_mask];
+            const unsigned sub_offset = link>>16;
+            const unsigned sub_size = 1<<(link&0xff);
+
+            const uint8_t sub_length = c_length-primary_bits;
+            for(unsigned index = reversed>>primary_bits; index < sub_size; index += 1<<sub_length)
+                _entries[sub_offset+index] = (i<<16)|sub_length;
+        }
+    }
 }
 
-void png::save(const image& img, const std::filesystem::path save_path)
+int ydeflate::huffman_table::decode(bit_reader& reader) const noexcept
 {
-    std::ofstream out_stream(save_path, std::ios::binary);
+    //longest deflate code is 15 bits
+    uint64_t bits = reader.peek(15);
 
-    std::vector<char> image_header;
-    //magic numbers for png
-    image_header.push_back(0x89);
+    uint32_t entry = _entries[bits&((1<<_primary_bits)-1)];
+    if(entry&0x100)
+    {
+        reader.consume(_primary_bits);
+        bits >>= _primary_bits;
 
-    //PNG in ascii
-    image_header.push_back('P');
-    image_header.push_back('N');
-    image_header.push_back('G');
+        entry = _entries[(entry>>16)+(bits&((1<<(entry&0xff))-1))];
+    }
 
-    //line ending
-    image_header.push_back(0x0d);
-    image_header.push_back(0x0a);
+    const uint8_t c_length = entry&0xff;
+    if(c_length==0)
+        return -1;
 
-    image_header.push_back(0x1a);
-    image_header.push_back(0x0a);
+    reader.consume(c_length);
 
+    return entry>>16;
+}
 
-    out_stream.write(image_header.data(), image_header.size());
+unsigned ydeflate::reverse_bits(unsigned code, const uint8_t length) noexcept
+{
+    unsigned reversed = 0;
+    for(uint8_t i = 0; i < length; ++i, code >>= 1)
+        reversed = (reversed<<1)|(code&0x1);
 
-    const std::string width_string = std::to_string(img.width);
-    image_header.insert(image_header.end(), width_string.begin(), width_string.end());
+    return reversed;
+}
 
-    const std::string height_string = std::to_string(img.height);
-    image_header.insert(image_header.end(), height_string.begin(), height_string.end());
+int ydeflate::huffman_distance(bit_reader& reader, int input_bits)
+{
+    const int extra_distance_bits = std::max(0, (input_bits-0x2)) / 2;
+
+    const int mover_val = input_bits-5;
 
-    const std::vector<std::string> encode_chunks{"IHDR", "IDAT", "IEND"};
-    for(int i = 0; i < encode_chunks.size(); ++i)
+    const int loop_range = mover_val/2+1;
+    for(int mli = 0; mli < loop_range; ++mli)
     {
-        const std::vector<char> data_chunk = create_chunk(img, encode_chunks[i]);
-        out_stream.write(data_chunk.data(), data_chunk.size());
+        input_bits += (mover_val+1-(2*mli))*(1<<mli);
     }
+
+    ++input_bits;
+
+    return input_bits + reader.read(extra_distance_bits);
 }
 
-std::vector<char> png::create_chunk(const image& img, const std::string name)
+int ydeflate::huffman_length(bit_reader& reader, const int input_bits)
 {
-    if(name=="IDAT")
+    const int extra_length_bits = std::max(0, (input_bits-0x105)) / 4;
+    switch(extra_length_bits)
     {
-        std::vector<uint8_t> image_bytes;
-        image_bytes.reserve(img.height*img.width*img.bpp+img.height);
+        case 0:
+            return input_bits-0xfe;
 
-        for(int y = 0; y < img.height; ++y)
-        {
-            const uint8_t line_filter = best_filter(img, y);
-            image_bytes.emplace_back(line_filter);
+        case 6:
+            return 258;
 
-            emplace_line(img, line_filter, y, image_bytes);
-        }
+        default:
+            const int mover_val = input_bits-0x10a;
+            const int loop_range = mover_val/4+1;
 
-        const std::vector<uint8_t> inflated_bytes = ydeflate::inflate(image_bytes);
+            int read_length = std::max(0, input_bits-0xfe);
+            for(int mli = 0; mli < loop_range; ++mli)
+            {
+                read_length += (mover_val+1-(4*mli))*(1<<mli);
+            }
 
-        return create_data(inflated_bytes, inflated_bytes.begin());
+            return read_length + reader.read(extra_length_bits);
     }
+}
 
-    std::vector<char> data_chunk;
+ydeflate::bit_reader::bit_reader(const uint8_t* data, const size_t size) noexcept
+: _pos(data), _end(data+size)
+{
+}
 
-    chunk_header(name, data_chunk);
+void ydeflate::bit_reader::set_input(const uint8_t* data, const size_t size,
+    const uint8_t* next_data, const size_t next_size) noexcept
+{
+    //drop the padding and the bits of bytes that were loaded but not counted
+    _count -= std::min(static_cast<size_t>(_count), _padding*8);
+    _buffer &= _count==64 ? ~0ull : ((1ull<<_count)-1);
+    _padding = 0;
 
-    if(name=="IHDR")
-    {
-        //4 bytes of width
-        data_chunk.push_back((img.width&0xff000000)>>24);
-        data_chunk.push_back((img.width&0xff0000)>>16);
-        data_chunk.push_back((img.width&0xff00)>>8);
-        data_chunk.push_back(img.width&0xff);
+    _pos = data;
+    _end = data+size;
 
-        //4 bytes of height
-        data_chunk.push_back((img.height&0xff000000)>>24);
-        data_chunk.push_back((img.height&0xff0000)>>16);
-        data_chunk.push_back((img.height&0xff00)>>8);
-        data_chunk.push_back(img.height&0xff);
+    _next_pos = next_data;
+    _next_end = next_data+next_size;
 
-        //bits per pixel, always 8 (bla bla bla not efficient)
-        data_chunk.push_back(8);
+    if(_pos==_end)
+    {
+        std::swap(_pos, _next_pos);
+        std::swap(_end, _next_end);
+    }
+}
 
-        //color type
-        //0100 bit adds alpha
-        //0010 bit adds color
-        //0001 bit means color from pallete
-        switch(img.bpp)
-        {
-            case 1:
-                //grayscale
-                data_chunk.push_back(0);
-                break;
-            case 2:
-                //grayscale with alpha
-                data_chunk.push_back(4);
-                break;
-            case 3:
-                //fullcolor
-                data_chunk.push_back(2);
-                break;
-            case 4:
-                //fullcolor with alpha
-                data_chunk.push_back(6);
-                break;
+void ydeflate::bit_reader::take_remaining(std::vector<uint8_t>& out) const
+{
+    out.insert(out.end(), _pos, _end);
+    out.insert(out.end(), _next_pos, _next_end);
+}
 
-            default:
-                throw std::runtime_error("invalid IHDR bpp type");
-        }
+uint64_t ydeflate::bit_reader::peek(const uint8_t num) noexcept
+{
+    if(_count<num)
+        refill();
 
-        //stuff that doesnt change, like png using deflate algorithm for compression
-        data_chunk.push_back(0);
-        data_chunk.push_back(0);
+    return _buffer&((1ull<<num)-1);
+}
 
-        //interlacing off
-        data_chunk.push_back(0);
-    }
+void ydeflate::bit_reader::consume(const uint8_t num) noexcept
+{
+    _buffer >>= num;
+    _count -= num;
+}
 
-    chunk_ending(data_chunk);
+unsigned ydeflate::bit_reader::read(const uint8_t num) noexcept
+{
+    const unsigned ret_val = peek(num);
+    consume(num);
 
-    return data_chunk;
+    return ret_val;
 }
 
-void png::chunk_header(const std::string name, std::vector<char>& write_data) noexcept
+void ydeflate::bit_reader::align_byte() noexcept
 {
-    write_data.reserve(4);
-    for(int cn = 0; cn < 4; ++cn)
-        write_data.emplace_back(name[cn]);
+    consume(_count&0x7);
 }
 
-void png::chunk_ending(std::vector<char>& write_data) noexcept
+void ydeflate::bit_reader::read_bytes(uint8_t* out, size_t num) noexcept
 {
-    const std::vector<uint32_t> crc_table = crc_table_gen();
+    //whatever is already in the buffer goes first
+    for(; num!=0 && _count!=0; --num, ++out)
+        *out = read(8);
 
-    uint32_t chunk_crc = 0xffffffff;
+    //the last refill can leave bits of uncounted bytes above _count
+    if(_count==0)
+        _buffer = 0;
 
-    const int crc_length = write_data.size();
+    const size_t available = std::min(num, static_cast<size_t>(_end-_pos));
+    std::memcpy(out, _pos, available);
+    _pos += available;
 
-    for(int b = 0; b < crc_length; ++b)
+    out += available;
+    num -= available;
+
+    if(num!=0 && _next_pos!=_next_end)
+    {
+        _pos = _next_pos;
+        _end = _next_end;
+        _next_pos = _next_end = nullptr;
+
+        read_bytes(out, num);
+    } else if(num!=0)
     {
-        chunk_crc = (crc_table[(chunk_crc^write_data[b])&0xff]^(chunk_crc>>8));
+        std::memset(out, 0, num);
+        _padding += num;
+        //keeps the padded bytes counted as consumed
+        _count = 0;
     }
+}
 
-    chunk_crc ^= 0xffffffff;
-    //crc stuff over
+size_t ydeflate::bit_reader::available_bits() const noexcept
+{
+    const size_t buffered = _count>_padding*8 ? _count-_padding*8 : 0;
+    return buffered+((_end-_pos)+(_next_end-_next_pos))*8;
+}
 
-    const int chunk_length = crc_length-4; //remove the name bytes
+bool ydeflate::bit_reader::overrun() const noexcept
+{
+    return _count<_padding*8;
+}
+
+void ydeflate::bit_reader::refill() noexcept
+{
+    if(_end-_pos>=8)
+    {
+        //little endian load, takes as many whole bytes as fit
+        uint64_t word;
+        std::memcpy(&word, _pos, 8);
 
-    write_data.insert(write_data.begin(), chunk_length&0xff);
-    write_data.insert(write_data.begin(), (chunk_length&0xff00)>>8);
-    write_data.insert(write_data.begin(), (chunk_length&0xff0000)>>16);
-    write_data.insert(write_data.begin(), (chunk_length&0xff000000)>>24);
+        _buffer |= word<<_count;
+        _pos += (63-_count)>>3;
+        _count |= 56;
+    } else
+    {
+        for(; _count<=56; _count += 8)
+        {
+            if(_pos==_end && _next_pos!=_next_end)
+            {
+                _pos = _next_pos;
+                _end = _next_end;
+                _next_pos = _next_end = nullptr;
+            }
 
+            if(_pos!=_end)
+            {
+                _buffer |= static_cast<uint64_t>(*_pos)<<_count;
+                ++_pos;
+            } else
+            {
+                ++_padding;
+            }
+        }
+    }
+}
 
-    write_data.push_back((chunk_crc&0xff000000)>>24);
-    write_data.push_back((chunk_crc&0xff0000)>>16);
-    write_data.push_back((chunk_crc&0xff00)>>8);
-    write_data.push_back(chunk_crc&0xff);
+std::vector<uint8_t> ydeflate::inflate(const std::vector<uint8_t>& input_data, const int level)
+{
+    deflater stream(level);
+
+    stream.write(input_data.data(), input_data.size());
+    stream.finish();
+
+    return stream.take_output();
 }
 
-std::vector<char> png::create_data(const storage_type& data_bytes, storage_type::const_iterator iter_start)
+std::vector<uint8_t> ydeflate::inflate_parallel(const std::vector<uint8_t>& input_data, const int level,
+    const unsigned threads_num)
 {
-    std::vector<char> data_chunk;
+    const size_t chunks_num = (input_data.size()+parallel_chunk_size-1)/parallel_chunk_size;
 
-    chunk_header("IDAT", data_chunk);
+    unsigned workers = threads_num==0 ? std::thread::hardware_concurrency() : threads_num;
+    workers = std::min(static_cast<size_t>(workers), chunks_num);
 
-    const int max_chunk_size = 8192; //idk where this comes from but gimp uses the same value :/
-    if(std::distance(iter_start, data_bytes.end())>max_chunk_size)
-    {
-        const storage_type::const_iterator end_iter = iter_start+max_chunk_size;
-        data_chunk.insert(data_chunk.end(), iter_start, end_iter);
-        chunk_ending(data_chunk);
+    if(workers<2)
+        return inflate(input_data, level);
 
-        const std::vector<char> next_chunk = create_data(data_bytes, end_iter);
-        data_chunk.insert(data_chunk.end(), next_chunk.begin(), next_chunk.end());
-    } else
+    std::vector<inflate_job> jobs(chunks_num);
+    for(size_t i = 0; i < chunks_num; ++i)
     {
-        data_chunk.insert(data_chunk.end(), iter_start, data_bytes.end());
-        chunk_ending(data_chunk);
-    }
+        const size_t start = i*parallel_chunk_size;
 
-    return data_chunk;
-}
+        jobs[i].data = input_data.data()+start;
+        jobs[i].size = std::min(parallel_chunk_size, input_data.size()-start);
+        jobs[i].dictionary_size = std::min(start, static_cast<size_t>(32768));
+        jobs[i].level = level;
+        jobs[i].last = i==chunks_num-1;
+    }
 
-void png::emplace_line(const image& img, const uint8_t filter, const int line, storage_type& out) noexcept
-{
-    for(int x = 0; x < img.width; ++x)
-        for(int b = 0; b < img.bpp; ++b)
-            out.emplace_back(filter_value(img, filter, x, line, b));
-}
+    std::vector<std::future<void>> finished;
+    finished.reserve(chunks_num);
 
-uint8_t png::defilter_value(const std::vector<uint8_t>& data, const uint8_t filter, const uint8_t val, const filter_values f) noexcept
-{
-    switch(filter)
     {
-        default:
-        case 0:
-        return val;
+        ythreads::pool<void(*)(inflate_job*), inflate_job*> workers_pool(workers, inflate_chunk);
 
-        case 1:
+        for(auto& job : jobs)
         {
-            if(f.x==0)
-                return val;
-            return modulo_add(val, data[f.index-f.bpp]);
+            finished.emplace_back(job.done.get_future());
+            workers_pool.run(&job);
         }
-        case 2:
-        {
-            if(f.y==0)
-                return val;
 
-            const unsigned above_index = f.index-(f.width*f.bpp);
-            return modulo_add(val, data[above_index]);
-        }
-        case 3:
-        {
-            const unsigned above_index = f.index-(f.width*f.bpp);
-            const uint8_t up_pixel = f.y==0 ? 0 : data[above_index];
-            const uint8_t left_pixel = f.x==0 ? 0 : data[f.index-f.bpp];
+        //the pool drops queued jobs when its destroyed, so everything has to finish first
+        for(auto& job_finished : finished)
+            job_finished.wait();
+    }
 
-            return modulo_add(val, (left_pixel+up_pixel)/2);
-        }
-        case 4:
-        {
-            const unsigned above_index = f.index-(f.width*f.bpp);
-            const uint8_t up_pixel = f.y==0 ? 0 : data[above_index];
-            const uint8_t left_pixel = f.x==0 ? 0 : data[f.index-f.bpp];
-            const uint8_t up_left_pixel = ((f.y==0) || (f.x==0)) ? 0 : data[above_index-f.bpp];
+    const std::array<uint8_t, 2> header = zlib_header(level);
+    std::vector<uint8_t> output(header.begin(), header.end());
 
-            return modulo_add(val, paeth_predictor(left_pixel, up_pixel, up_left_pixel));
-        }
+    uint32_t adler = 1;
+    for(size_t i = 0; i < chunks_num; ++i)
+    {
+        //rethrows whatever the worker threw
+        finished[i].get();
+
+        output.insert(output.end(), jobs[i].output.begin(), jobs[i].output.end());
+        adler = adler32_combine(adler, jobs[i].adler, jobs[i].size);
     }
+
+    output.push_back((adler>>24)&0xff);
+    output.push_back((adler>>16)&0xff);
+    output.push_back((adler>>8)&0xff);
+    output.push_back(adler&0xff);
+
+    return output;
 }
 
-uint8_t png::filter_value(const image& img, const uint8_t filter, const int x, const int y, const uint8_t col) noexcept
+void ydeflate::inflate_chunk(inflate_job* job)
 {
-    const uint8_t c_color = img.pixel_color(x, y, col);
-
-    switch(filter)
+    try
     {
-        default:
-        case 0:
-        return c_color;
+        deflater stream(job->level, true);
 
-        case 1:
-        {
-            if(x==0)
-                return c_color;
-            return modulo_sub(c_color, img.pixel_color(x-1, y, col));
-        }
+        stream.set_dictionary(job->data-job->dictionary_size, job->dictionary_size);
+        stream.write(job->data, job->size);
 
-        case 2:
+        if(job->last)
         {
-            if(y==0)
-                return c_color;
-            return modulo_sub(c_color, img.pixel_color(x, y-1, col));
-        }
-
-        case 3:
+            stream.finish();
+        } else
         {
-            const int left_pixel = x==0 ? 0 : img.pixel_color(x-1, y, col);
-            const int up_pixel = y==0 ? 0 : img.pixel_color(x, y-1, col);
-            return modulo_sub(c_color, (left_pixel+up_pixel)/2);
+            stream.flush();
         }
 
-        case 4:
-        {
-            const int left_pixel = x==0 ? 0 : img.pixel_color(x-1, y, col);
-            const int up_pixel = y==0 ? 0 : img.pixel_color(x, y-1, col);
-            const int up_left_pixel = ((x==0) || (y==0)) ? 0 : img.pixel_color(x-1, y-1, col);
+        job->output = stream.take_output();
+        job->adler = stream.checksum();
 
-            return modulo_sub(c_color, paeth_predictor(left_pixel, up_pixel, up_left_pixel));
-        }
+        job->done.set_value();
+    } catch(...)
+    {
+        job->done.set_exception(std::current_exception());
     }
 }
 
-uint8_t png::best_filter(const image& img, const int line) noexcept
+ydeflate::deflater::deflater(const int level, const bool raw)
+: _level(std::clamp(level, 0, 9)), _raw(raw), _window(window_size*2),
+_head(1<<hash_bits, 0), _prev(window_size, 0)
 {
-    std::array<unsigned, 5> sum{0, 0, 0, 0, 0};
+    //same tradeoffs as zlib uses for its levels
+    const std::array<level_config, 10> configs{{
+        {0, 0, 0, 0},
+        {4, 4, 8, 4},
+        {4, 5, 16, 8},
+        {4, 6, 32, 32},
+        {4, 4, 16, 16},
+        {8, 16, 32, 32},
+        {8, 16, 128, 128},
+        {8, 32, 128, 256},
+        {32, 128, 258, 1024},
+        {32, 258, 258, 4096}}};
+
+    _config = configs[_level];
+
+    _literal_freqs.fill(0);
+    _distance_freqs.fill(0);
+    _symbols.reserve(max_block_symbols);
+
+    if(_raw)
+        return;
 
-    for(uint8_t f = 0; f < 5; ++f)
-    {
-        for(int x = 0; x < img.width; ++x)
-        {
-            for(uint8_t b = 0; b < img.bpp; ++b)
-            {
-                sum[f] += filter_value(img, f, x, line, b);
-            }
-        }
-    }
+    const std::array<uint8_t, 2> header = zlib_header(_level);
 
-    if(sum[0]<=sum[1] && sum[0]<=sum[2] && sum[0]<=sum[3] && sum[0]<=sum[4])
-        return 0;
+    _writer.write(header[0], 8);
+    _writer.write(header[1], 8);
+}
 
-    if(sum[1]<=sum[0] && sum[1]<=sum[2] && sum[1]<=sum[3] && sum[1]<=sum[4])
-        return 1;
+void ydeflate::deflater::write(const uint8_t* data, const size_t size)
+{
+    _adler = adler32(_adler, data, size);
+    append(data, size);
+}
 
-    if(sum[2]<=sum[1] && sum[2]<=sum[0] && sum[2]<=sum[3] && sum[2]<=sum[4])
-        return 2;
+void ydeflate::deflater::append(const uint8_t* data, const size_t size)
+{
+    size_t written = 0;
+    while(written<size)
+    {
+        if(_window_end==_window.size())
+            slide();
 
-    if(sum[3]<=sum[1] && sum[3]<=sum[2] && sum[3]<=sum[0] && sum[3]<=sum[4])
-        return 3;
+        const size_t copy_size = std::min(size-written, _window.size()-_window_end);
+        std::memcpy(_window.data()+_window_end, data+written, copy_size);
 
-    if(sum[4]<=sum[1] && sum[4]<=sum[2] && sum[4]<=sum[3] && sum[4]<=sum[0])
-        return 4;
+        _window_end += copy_size;
+        written += copy_size;
 
-    return 0;
+        process(false);
+    }
 }
 
-std::vector<uint32_t> png::crc_table_gen() noexcept
+void ydeflate::deflater::set_dictionary(const uint8_t* data, size_t size)
 {
-    std::vector<uint32_t> crc_table;
-    crc_table.reserve(256);
-
-    for(int i = 0; i < 256; ++i)
+    if(size>window_size)
     {
-        uint32_t table_num = static_cast<uint32_t>(i);
+        data += size-window_size;
+        size = window_size;
+    }
 
-        for(int l = 0; l < 8; ++l)
-        {
-            if(table_num&0x1)
-            {
-                table_num = 0xedb88320^(table_num>>1);
-            } else
-            {
-                table_num >>= 1;
-            }
-        }
+    std::memcpy(_window.data(), data, size);
 
-        crc_table.emplace_back(table_num);
-    }
+    _window_end = size;
+    _pos = size;
+    _block_start = size;
 
-    return crc_table;
+    if(_level==1)
+    {
+        for(size_t pos = 1; pos+4 <= size; ++pos)
+            _head[fast_hash(_window.data()+pos)] = pos;
+    } else if(_level>1)
+    {
+        //position 0 would be an empty slot anyway
+        for(size_t pos = 1; pos+min_match <= size; ++pos)
+            insert_hash(pos);
+    }
 }
 
-uint8_t png::paeth_predictor(const int left, const int up, const int up_left) noexcept
+void ydeflate::deflater::flush()
 {
-    const int initial_est = left + up - up_left;
+    process(true);
+    emit_block(false);
 
-    const int distance_left = std::abs(initial_est - left);
-    const int distance_up = std::abs(initial_est - up);
-    const int distance_up_left = std::abs(initial_est - up_left);
+    _writer.write(0, 3);
+    _writer.align_byte();
 
-    if((distance_left<=distance_up) && (distance_left<=distance_up_left))
-    {
-        return left;
-    } else if(distance_up<=distance_up_left)
-    {
-        return up;
-    } else
-    {
-        return up_left;
-    }
+    _writer.write(0, 16);
+    _writer.write(0xffff, 16);
 }
 
-uint8_t png::modulo_sub(const int lval, const int rval) noexcept
+void ydeflate::deflater::finish()
 {
-    return (lval - rval) % 256;
+    process(true);
+    emit_block(true);
+
+    _writer.align_byte();
+
+    if(_raw)
+        return;
+
+    _writer.write((_adler>>24)&0xff, 8);
+    _writer.write((_adler>>16)&0xff, 8);
+    _writer.write((_adler>>8)&0xff, 8);
+    _writer.write(_adler&0xff, 8);
 }
 
-uint8_t png::modulo_add(const int lval, const int rval) noexcept
+uint32_t ydeflate::deflater::checksum() const noexcept
 {
-    return lval + rval - 256;
+    return _adler;
 }
 
-image pgm::read(const std::filesystem::path load_path)
+std::vector<uint8_t> ydeflate::deflater::take_output()
 {
-    //im not parsing comments because NO
-    std::ifstream read_stream(load_path, std::ios::binary);
+    std::vector<uint8_t> output;
+    std::swap(output, _writer.data);
 
-    std::array<char, 2> data_type;
-    read_stream.read(data_type.data(), 2);
+    return output;
+}
 
-    image img;
-    if(strncmp(data_type.data(), "P2", 2)==0||strncmp(data_type.data(), "P5", 2)==0)
-    {
-        std::string width_string;
-        read_stream >> width_string;
-        img.width = std::stoul(width_string);
+size_t ydeflate::deflater::trial_bits(const uint8_t* data, const size_t size)
+{
+    //stored as is, every candidate costs the same
+    if(_level==0)
+        return size*8;
 
-        std::string height_string;
-        read_stream >> height_string;
-        img.height = std::stoul(height_string);
+    //happens about once every 32kb, the copies cost less than logging every entry a slide moves
+    const bool slides = size>_window.size()-_window_end;
+    if(slides)
+    {
+        _trial_window = _window;
+        _trial_head = _head;
 
-        const int image_size = img.width*img.height;
-        img.data.reserve(image_size);
+        if(_level>1)
+            _trial_prev = _prev;
+    }
 
-        std::string max_val_string;
-        read_stream >> max_val_string;
-        const float max_val = std::stof(max_val_string);
+    const size_t window_end = _window_end;
+    const size_t pos = _pos;
+    const ptrdiff_t block_start = _block_start;
+    const bool match_available = _match_available;
+    const unsigned prev_length = _prev_length;
+    const size_t prev_match = _prev_match;
+    const size_t symbols_size = _symbols.size();
+    const std::array<unsigned, 286> literal_freqs = _literal_freqs;
+    const std::array<unsigned, 30> distance_freqs = _distance_freqs;
+
+    //flushing so the end of the data is parsed too, blocks that fill up on the way are added to _trial_bits
+    _trial = true;
+    _trial_bits = 0;
+    append(data, size);
+    process(true);
+    _trial = false;
+
+    const block_plan plan = plan_block();
+    const size_t bits = _trial_bits+std::min({plan.stored_bits, plan.fixed_bits, plan.dynamic_bits});
+
+    if(slides)
+    {
+        std::swap(_window, _trial_window);
+        std::swap(_head, _trial_head);
 
-        if(strncmp(data_type.data(), "P2", 2)==0)
+        if(_level>1)
+            std::swap(_prev, _trial_prev);
+    } else
+    {
+        //newest first, so an entry changed twice gets its oldest value back
+        for(auto change = _trial_changes.rbegin(); change!=_trial_changes.rend(); ++change)
         {
-            //ascii
-            for(int i = 0; i < image_size; ++i)
-            {
-                std::string color_string;
-                read_stream >> color_string;
+            _head[change->hash] = change->head;
 
-                img.data.emplace_back(std::round(255*(std::stoi(color_string)/max_val)));
-            }
-        } else
-        {
-            //binary
-            for(int i = 0; i < image_size; ++i)
-            {
-                img.data.emplace_back(std::round(255*(read_stream.get()/max_val)));
-            }
+            if(_level>1)
+                _prev[change->slot] = change->prev;
         }
-    } else
+    }
+
+    _trial_changes.clear();
+
+    //the data past _window_end gets written over by the next write
+    _window_end = window_end;
+    _pos = pos;
+    _block_start = block_start;
+    _match_available = match_available;
+    _prev_length = prev_length;
+    _prev_match = prev_match;
+    _literal_freqs = literal_freqs;
+    _distance_freqs = distance_freqs;
+
+    if(!_trial_symbols.empty())
     {
-        throw std::runtime_error("pgm::read wrong magic numbers");
+        std::swap(_symbols, _trial_symbols);
+        _trial_symbols.clear();
     }
 
-    img.bpp = 1;
+    _symbols.resize(symbols_size);
 
-    return img;
+    return bits;
 }
 
-void pgm::save(const image& img, const std::filesystem::path save_path)
+void ydeflate::deflater::process(const bool flushing)
 {
-    if(img.bpp!=1)
+    if(_level==0)
+    {
+        //nothing to search for, blocks are cut when they fill up or the stream ends
+        _pos = _window_end;
+
+        if(_pos-_block_start>=0xffff)
+            emit_block(false);
+
         return;
+    }
 
-    std::ofstream out_stream(save_path, std::ios::binary);
+    if(_level==1)
+    {
+        process_fast(flushing);
+        return;
+    }
 
-    std::vector<char> image_header;
-    //magic number for the binary grayscale format
-    image_header.push_back('P');
-    image_header.push_back('5');
+    while(true)
+    {
+        const size_t lookahead = _window_end-_pos;
+        if(lookahead==0 || (!flushing && lookahead<min_lookahead))
+            break;
 
-    image_header.push_back('\n');
+        unsigned match_length = min_match-1;
+        size_t match_start = 0;
 
-    const std::string width_string = std::to_string(img.width);
-    image_header.insert(image_header.end(), width_string.begin(), width_string.end());
+        if(lookahead>=min_match)
+        {
+            const size_t candidate = _head[(
+                (static_cast<uint32_t>(_window[_pos])|(_window[_pos+1]<<8)|(_window[_pos+2]<<16))
+                *2654435761u)>>(32-hash_bits)];
 
-    image_header.push_back('\n');
+            insert_hash(_pos);
 
-    const std::string height_string = std::to_string(img.height);
-    image_header.insert(image_header.end(), height_string.begin(), height_string.end());
+            if(candidate!=0 && _prev_length<_config.max_lazy && _pos-candidate<=window_size-min_lookahead)
+            {
+                match_length = longest_match(candidate, _prev_length, match_start);
 
-    image_header.push_back('\n');
+                //a short match far away costs more bits than the literals
+                if(match_length==min_match && _pos-match_start>4096)
+                    match_length = min_match-1;
+            }
+        }
 
-    //max value for a color which is 255
-    image_header.push_back('2');
-    image_header.push_back('5');
-    image_header.push_back('5');
+        if(_prev_length>=min_match && match_length<=_prev_length)
+        {
+            //the match from the previous position was at least as good
+            add_match(_prev_length, _pos-1-_prev_match);
 
-    image_header.push_back('\n');
+            //the current position is already hashed
+            const size_t match_end = _pos-1+_prev_length;
+            for(++_pos; _pos < match_end; ++_pos)
+            {
+                if(_window_end-_pos>=min_match)
+                    insert_hash(_pos);
+            }
 
-    out_stream.write(image_header.data(), image_header.size());
+            _match_available = false;
+            _prev_length = min_match-1;
+        } else
+        {
+            if(_match_available)
+                add_literal(_window[_pos-1]);
+
+            _match_available = true;
+            _prev_length = match_length;
+            _prev_match = match_start;
 
+            ++_pos;
+        }
+
+        if(_symbols.size()>=max_block_symbols)
+        {
+            //the block ends at _pos, so the byte still waiting on a lazy match has to go in it
+            if(_match_available)
+            {
+                add_literal(_window[_pos-1]);
 
-    const int image_size = img.data.size();
+                _match_available = false;
+                _prev_length = min_match-1;
+            }
 
-    std::vector<char> image_data;
-    //each color value is separated by a whitespace (therefore twice the bytes)
-    image_data.reserve(image_size);
+            emit_block(false);
+        }
+    }
 
-    for(int i = 0; i < image_size; ++i)
+    if(flushing && _match_available)
     {
-        image_data.emplace_back(static_cast<char>(img.data[i]));
-    }
+        add_literal(_window[_pos-1]);
 
-    out_stream.write(image_data.data(), image_data.size());
+        _match_available = false;
+        _prev_length = min_match-1;
+    }
 }
 
-void ppm::save(const image& img, const std::filesystem::path save_path)
+void ydeflate::deflater::process_fast(const bool flushing)
 {
-    if(img.bpp!=3)
-        return;
+    //positions since the last match, the longer it goes the more positions are skipped without a lookup
+    size_t misses = 0;
 
-    std::ofstream out_stream(save_path, std::ios::binary);
+    while(true)
+    {
+        const size_t lookahead = _window_end-_pos;
+        if(lookahead==0 || (!flushing && lookahead<min_lookahead))
+            break;
 
-    std::vector<char> image_header;
-    //magic number for the binary rgb format
-    image_header.push_back('P');
-    image_header.push_back('6');
+        if(lookahead>=4)
+        {
+            const uint8_t* current = _window.data()+_pos;
 
-    image_header.push_back('\n');
+            uint32_t current_word;
+            std::memcpy(&current_word, current, 4);
 
-    const std::string width_string = std::to_string(img.width);
-    image_header.insert(image_header.end(), width_string.begin(), width_string.end());
+            const uint32_t hash = fast_hash(current);
 
-    image_header.push_back('\n');
+            const size_t candidate = _head[hash];
 
-    const std::string height_string = std::to_string(img.height);
-    image_header.insert(image_header.end(), height_string.begin(), height_string.end());
+            //level 1 has no chains to undo
+            if(_trial)
+                _trial_changes.push_back({hash, 0, _head[hash], 0});
 
-    image_header.push_back('\n');
+            _head[hash] = _pos;
 
-    //max value for a color which is 255
-    image_header.push_back('2');
-    image_header.push_back('5');
-    image_header.push_back('5');
+            uint32_t candidate_word;
+            std::memcpy(&candidate_word, _window.data()+candidate, 4);
 
-    image_header.push_back('\n');
+            if(candidate!=0 && _pos-candidate<=window_size-min_lookahead && candidate_word==current_word)
+            {
+                const uint8_t* match = _window.data()+candidate;
+                const size_t max_length = std::min(static_cast<size_t>(max_match), lookahead);
 
-    out_stream.write(image_header.data(), image_header.size());
+                size_t length = 4;
+                while(length+8<=max_length)
+                {
+                    uint64_t match_word;
+                    uint64_t current_long;
+                    std::memcpy(&match_word, match+length, 8);
+                    std::memcpy(&current_long, current+length, 8);
+
+                    const uint64_t difference = match_word^current_long;
+                    if(difference!=0)
+                    {
+                        length += __builtin_ctzll(difference)/8;
+                        break;
+                    }
+
+                    length += 8;
+                }
 
+                if(length+8>max_length)
+                {
+                    while(length<max_length && match[length]==current[length])
+                        ++length;
+                }
 
-    const int image_size = img.data.size();
+                add_match(length, _pos-candidate);
+                _pos += length;
 
-    std::vector<char> image_data;
-    //each color value is separated by a whitespace (therefore twice the bytes)
-    image_data.reserve(image_size);
+                misses = 0;
 
-    for(int y = 0; y < img.height; ++y)
-    {
-        for(int x = 0; x < img.width; ++x)
-        {
-            for(uint8_t bppi = 0; bppi < img.bpp; ++bppi)
-            {
-                image_data.emplace_back(static_cast<char>(img.data[y*img.width*img.bpp+x*img.bpp+bppi]));
+                if(_symbols.size()>=max_block_symbols)
+                    emit_block(false);
+
+                continue;
             }
         }
-    }
 
-    out_stream.write(image_data.data(), image_data.size());
+        //incompressible data gets through quickly, same as lz4 does it
+        const size_t literals_end = std::min(_pos+1+(misses++>>5), _window_end);
+        for(; _pos < literals_end; ++_pos)
+            add_literal(_window[_pos]);
+
+        if(_symbols.size()>=max_block_symbols)
+            emit_block(false);
+    }
 }
 
-std::vector<uint8_t> ydeflate::deflate(const std::vector<uint8_t>& input_data)
+void ydeflate::deflater::insert_hash(const size_t pos)
 {
-    std::vector<uint8_t> deflated_data;
-
-    const uint8_t compression_info = (input_data[0]>>4);
-    const uint8_t compression_method = (input_data[0]&0x0f);
+    const uint32_t hash = ((static_cast<uint32_t>(_window[pos])|(_window[pos+1]<<8)|(_window[pos+2]<<16))
+        *2654435761u)>>(32-hash_bits);
 
-    if(compression_method!=8 | compression_info>7)
-    {
-        //all deflate streams have 8 compression method (at the moment)
-        return deflated_data;
-    }
+    const size_t slot = pos&(window_size-1);
+    if(_trial)
+        _trial_changes.push_back({hash, static_cast<uint16_t>(slot), _head[hash], _prev[slot]});
 
-    const uint8_t compression_level = (input_data[1]>>6);
-    const bool preset_dict = ((input_data[1]>>5)&0x1);
+    _prev[slot] = _head[hash];
+    _head[hash] = pos;
+}
 
-    const std::array<char, 4> checksum_str = {
-        static_cast<char>(input_data[0]),
-        static_cast<char>(input_data[1]), 0, 0};
+uint32_t ydeflate::deflater::fast_hash(const uint8_t* data) noexcept
+{
+    uint32_t word;
+    std::memcpy(&word, data, 4);
 
-    const unsigned checksum_num = chars_to_number<unsigned>(checksum_str.data());;
+    //hashes 4 bytes so most candidates that survive the check are real matches
+    return (word*2654435761u)>>(32-hash_bits);
+}
 
-    if(checksum_num%31!=0)
-    {
-        //the checksum is just the 2 bytes being divisible by 31
-        return deflated_data;
-    }
+unsigned ydeflate::deflater::longest_match(size_t candidate, const unsigned prev_length, size_t& match_start) const noexcept
+{
+    const size_t max_length = std::min(static_cast<size_t>(max_match), _window_end-_pos);
+    const size_t limit = _pos>window_size-min_lookahead ? _pos-(window_size-min_lookahead) : 0;
 
-    bool last_block = false;
-    uint8_t compression_type;
+    unsigned chain_length = _config.max_chain;
+    if(prev_length>=_config.good_length)
+        chain_length >>= 2;
 
-    f_pos pos{2, 0};
+    const unsigned nice_length = std::min(static_cast<size_t>(_config.nice_length), max_length);
 
-    //2 first bytes are zlib stuff so start reading DEFLATE blocks at 2 offset
-    //int might be too small for large data (gigabytes range)
-    //but my implementation isnt even fast enough to read that much in a realistic amount of time
-    while(!last_block)
+    unsigned best_length = prev_length;
+    if(best_length>=max_length)
+        return best_length;
+
+    const uint8_t* current = _window.data()+_pos;
+    do
     {
-        last_block = ((input_data[pos.byte]>>pos.bit)&0x1);
-        shift_offset(pos);
+        const uint8_t* match = _window.data()+candidate;
 
-        compression_type = ((input_data[pos.byte]>>pos.bit)&0x1);
-        shift_offset(pos);
-        compression_type |= ((input_data[pos.byte]>>pos.bit)&0x1)<<1;
-        shift_offset(pos);
+        //the byte that would make this match longer than the best one has to fit first
+        if(match[best_length]!=current[best_length] || match[0]!=current[0] || match[1]!=current[1])
+            continue;
 
-        //00 - no compression
-        //01 - compressed with fixed huffman codes
-        //10 - compressed with dynamic huffman codes
-        //11 - error
-        switch(compression_type)
+        unsigned length = 2;
+        //8 bytes at a time, the window always has room past the lookahead
+        while(length+8<=max_length)
         {
-            case 0:
-                uncompressed_block(input_data, deflated_data, pos);
-            break;
+            uint64_t match_word;
+            uint64_t current_word;
+            std::memcpy(&match_word, match+length, 8);
+            std::memcpy(&current_word, current+length, 8);
 
-            case 1:
-                static_huffman_block(input_data, deflated_data, pos);
-            break;
+            const uint64_t difference = match_word^current_word;
+            if(difference!=0)
+            {
+                length += __builtin_ctzll(difference)/8;
+                break;
+            }
 
-            case 2:
-                dynamic_huffman_block(input_data, deflated_data, pos);
-            break;
+            length += 8;
+        }
 
-            case 3:
-            default:
-                return deflated_data;
-            break;
+        while(length<max_length && match[length]==current[length])
+            ++length;
+
+        if(length>best_length)
+        {
+            best_length = length;
+            match_start = candidate;
+
+            if(length>=nice_length)
+                break;
         }
-    }
+    } while((candidate = _prev[candidate&(window_size-1)])>limit && --chain_length!=0);
 
-    return deflated_data;
+    return best_length;
 }
 
-void ydeflate::uncompressed_block(const std::vector<uint8_t>& input_vec, std::vector<uint8_t>& data_vec, f_pos& pos)
+void ydeflate::deflater::slide()
 {
-    if(pos.bit>0)
-        ++pos.byte;
+    //stored blocks are written straight from the window
+    if(_level==0)
+        emit_block(false);
 
-    pos.bit = 0; //skip the partial bytes
+    std::memmove(_window.data(), _window.data()+window_size, window_size);
 
-    const std::array<char, 4> data_length_str = {
-        static_cast<char>(input_vec[pos.byte]),
-        static_cast<char>(input_vec[pos.byte+1]), 0, 0};
+    _window_end -= window_size;
+    _pos -= window_size;
+    _block_start -= window_size;
+    _prev_match = _prev_match>=window_size ? _prev_match-window_size : 0;
 
-    pos.byte+=4; //skip the one's complement of length
-    unsigned data_length;
-    std::memcpy(&data_length, data_length_str.data(), 4);
+    for(auto& head : _head)
+        head = head>window_size ? head-window_size : 0;
 
-    data_vec.reserve(data_length);
-    for(int d = 0; d < data_length; ++d)
-    {
-        data_vec.emplace_back(input_vec[pos.byte++]);
-    }
+    //level 1 never follows chains
+    if(_level==1)
+        return;
+
+    for(auto& prev : _prev)
+        prev = prev>window_size ? prev-window_size : 0;
 }
 
-void ydeflate::static_huffman_block(const std::vector<uint8_t>& input_vec, std::vector<uint8_t>& data_vec, f_pos& pos)
+void ydeflate::deflater::add_literal(const uint8_t value) noexcept
 {
-    while(true)
-    {
-        uint8_t check_bits = 0;
-        for(int d = 0; d < 7; ++d)
-        {
-            check_bits |= (input_vec[pos.byte]>>pos.bit)&0x1;
-            check_bits <<= 1;
-            shift_offset(pos);
-        }
+    _symbols.push_back(value);
+    ++_literal_freqs[value];
+}
 
-        int out_bits;
-        if(check_bits>0xc8)
-        {
-            //its 144-255
-            check_bits |= (input_vec[pos.byte]>>pos.bit)&0x1;
-            shift_offset(pos);
+void ydeflate::deflater::add_match(const unsigned length, const unsigned distance) noexcept
+{
+    _symbols.push_back(length|(distance<<16));
 
-            out_bits = static_cast<unsigned>(check_bits);
+    ++_literal_freqs[257+length_index(length)];
+    ++_distance_freqs[distance_index(distance)];
+}
 
-            out_bits <<= 1;
-            out_bits |= (input_vec[pos.byte]>>pos.bit)&0x1;
-            shift_offset(pos);
+namespace
+{
+    //code length codes are stored in this order
+    constexpr std::array<uint8_t, 19> length_codes_order{16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    //extra bits after the repeat symbols 16, 17 and 18
+    constexpr std::array<uint8_t, 19> repeat_extra{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 7};
+}
 
-            out_bits -= 0x100;
+ydeflate::deflater::block_plan ydeflate::deflater::plan_block() const
+{
+    block_plan plan;
 
-            data_vec.push_back(out_bits);
-            continue;
-        } else if(check_bits>0xbf)
-        {
-            //its 280-287
-            check_bits |= (input_vec[pos.byte]>>pos.bit)&0x1;
-            out_bits = check_bits + 0x58;
+    //end of block
+    std::array<unsigned, 286> literal_freqs = _literal_freqs;
+    literal_freqs[256] = 1;
 
-            shift_offset(pos);
-        } else if(check_bits>0x2e)
-        {
-            //its 0-143
-            check_bits |= (input_vec[pos.byte]>>pos.bit)&0x1;
-            check_bits -= 0x30;
+    plan.literal_lengths = huffman_lengths(literal_freqs.data(), literal_freqs.size(), 15);
+    plan.distance_lengths = huffman_lengths(_distance_freqs.data(), _distance_freqs.size(), 15);
 
-            shift_offset(pos);
+    //a block without matches still needs one distance code
+    if(std::all_of(plan.distance_lengths.begin(), plan.distance_lengths.end(), [](int l){return l==0;}))
+        plan.distance_lengths[0] = 1;
 
-            data_vec.push_back(check_bits);
-            continue;
-        } else
-        {
-            //its 256-279
-            check_bits >>= 1;
-            if(check_bits!=0)
-                out_bits = check_bits + 0x100;
-            else
-                break;
-        }
+    plan.literals_used = 286;
+    while(plan.literal_lengths[plan.literals_used-1]==0)
+        --plan.literals_used;
+
+    plan.distances_used = 30;
+    while(plan.distance_lengths[plan.distances_used-1]==0)
+        --plan.distances_used;
+
+    //literal and distance lengths are run length encoded with symbols 16, 17 and 18
+    std::vector<int> all_lengths(plan.literal_lengths.begin(), plan.literal_lengths.begin()+plan.literals_used);
+    all_lengths.insert(all_lengths.end(), plan.distance_lengths.begin(), plan.distance_lengths.begin()+plan.distances_used);
+
+    std::array<unsigned, 19> length_freqs{};
 
-        const int read_length = huffman_length(input_vec, pos, out_bits);
+    const int all_size = all_lengths.size();
+    for(int i = 0; i < all_size;)
+    {
+        const int c_length = all_lengths[i];
+
+        int run = 1;
+        while(i+run<all_size && all_lengths[i+run]==c_length)
+            ++run;
 
-        int start_distance = 0;
-        for(int d = 0; d < 5; ++d)
+        if(c_length==0 && run>=11)
         {
-            start_distance <<= 1;
-            start_distance |= (input_vec[pos.byte]>>pos.bit)&0x1;
-            shift_offset(pos);
-        }
+            run = std::min(run, 138);
+            plan.length_symbols.push_back(18|((run-11)<<8));
+        } else if(c_length==0 && run>=3)
+        {
+            plan.length_symbols.push_back(17|((run-3)<<8));
+        } else if(c_length!=0 && run>=4)
+        {
+            //the first one is written normally and the rest repeat it
+            plan.length_symbols.push_back(c_length);
+            ++length_freqs[c_length];
 
-        const int read_distance = huffman_distance(input_vec, pos, start_distance);
+            run = std::min(run-1, 6);
+            plan.length_symbols.push_back(16|((run-3)<<8));
 
-        data_vec.reserve(read_length);
-        const unsigned deflate_data_end = data_vec.size();
-        for(int rb = 0; rb < read_length; ++rb)
+            ++run;
+        } else
         {
-            data_vec.emplace_back(data_vec[deflate_data_end-read_distance+rb]);
+            run = 1;
+            plan.length_symbols.push_back(c_length);
         }
+
+        ++length_freqs[plan.length_symbols.back()&0xff];
+        i += run;
     }
-}
 
-void ydeflate::dynamic_huffman_block(const std::vector<uint8_t>& input_vec, std::vector<uint8_t>& data_vec, f_pos& pos)
-{
-    int codes_length_total = read_forward(input_vec, pos, 5);
-    codes_length_total += 257;
+    plan.length_code_lengths = huffman_lengths(length_freqs.data(), length_freqs.size(), 7);
+
+    plan.length_codes_used = 19;
+    while(plan.length_codes_used>4 && plan.length_code_lengths[length_codes_order[plan.length_codes_used-1]]==0)
+        --plan.length_codes_used;
 
-    int codes_distance_total = read_forward(input_vec, pos, 5);
-    ++codes_distance_total;
+    size_t extra_bits = 0;
+    plan.dynamic_bits = 3+14+plan.length_codes_used*3;
+    plan.fixed_bits = 3;
 
-    const int code_length = read_forward(input_vec, pos, 4) + 4;
+    for(int i = 0; i < 19; ++i)
+        plan.dynamic_bits += length_freqs[i]*(plan.length_code_lengths[i]+repeat_extra[i]);
 
-    std::vector<int> length_codes_temp(19, 0);
-    for(int lc = 0; lc < 19; ++lc)
+    for(int i = 0; i < 286; ++i)
     {
-        if(lc<code_length)
-            length_codes_temp[lc] = read_forward(input_vec, pos, 3);
+        plan.dynamic_bits += literal_freqs[i]*plan.literal_lengths[i];
+        plan.fixed_bits += literal_freqs[i]*fixed_literal_lengths[i];
+
+        if(i>256)
+            extra_bits += literal_freqs[i]*length_extra[i-257];
     }
 
-    //reorder the codes
-    const std::vector<int> length_codes_vec = {length_codes_temp[3], length_codes_temp[17],
-        length_codes_temp[15], length_codes_temp[13], length_codes_temp[11], length_codes_temp[9],
-        length_codes_temp[7], length_codes_temp[5], length_codes_temp[4], length_codes_temp[6],
-        length_codes_temp[8], length_codes_temp[10], length_codes_temp[12], length_codes_temp[14],
-        length_codes_temp[16], length_codes_temp[18], length_codes_temp[0], length_codes_temp[1], length_codes_temp[2]};
+    for(int i = 0; i < 30; ++i)
+    {
+        plan.dynamic_bits += _distance_freqs[i]*plan.distance_lengths[i];
+        plan.fixed_bits += _distance_freqs[i]*fixed_distance_lengths[i];
+
+        extra_bits += _distance_freqs[i]*distance_extra[i];
+    }
 
-    const std::vector<int> length_codes_bin = lengths_to_prefix(length_codes_vec).vec;
+    plan.dynamic_bits += extra_bits;
+    plan.fixed_bits += extra_bits;
 
-    const int lci_size = length_codes_bin.size();
+    //header, length and its complement for every 64kb piece
+    const size_t raw_size = _pos-_block_start;
+    plan.stored_bits = _block_start>=0 ? (raw_size+5*(raw_size/0xffff+1))*8+7 : SIZE_MAX;
 
-    std::vector<int> codewords_vec;
-    uint_fast16_t reading_bits = 0;
-    uint_fast8_t currcode_length = 0;
-    for(;codes_length_total!=0; reading_bits <<= 1)
+    return plan;
+}
+
+void ydeflate::deflater::emit_block(const bool last)
+{
+    const size_t raw_size = _pos-_block_start;
+
+    if(!last && raw_size==0)
+        return;
+
+    const uint8_t* raw_data = _window.data()+_block_start;
+
+    if(_trial)
+    {
+        //only priced, the symbols from before the trial are kept the first time so they can be put back
+        const block_plan plan = plan_block();
+        _trial_bits += std::min({plan.stored_bits, plan.fixed_bits, plan.dynamic_bits});
+
+        if(_trial_symbols.empty())
+            std::swap(_trial_symbols, _symbols);
+    } else if(_level==0)
     {
-        reading_bits |= (input_vec[pos.byte]>>pos.bit)&0x1;
-        shift_offset(pos);
-        currcode_length++;
+        emit_stored(raw_data, raw_size, last);
+    } else
+    {
+        const block_plan plan = plan_block();
 
-        int code_index = lci_size;
-        for(int lci = 0; lci < lci_size; ++lci)
+        if(plan.stored_bits<=std::min(plan.dynamic_bits, plan.fixed_bits))
         {
-            if(length_codes_bin[lci]==reading_bits)
-            {
-                code_index = lci;
-                break;
-            }
-        }
+            emit_stored(raw_data, raw_size, last);
+        } else if(plan.fixed_bits<=plan.dynamic_bits)
+        {
+            _writer.write(last|(1<<1), 3);
 
-        if(code_index<19 && length_codes_vec[code_index]==currcode_length)
+            emit_codes(fixed_literal_codes.data(), fixed_literal_lengths.data(),
+                fixed_distance_codes.data(), fixed_distance_lengths.data());
+        } else
         {
-            if(code_index<16)
-            {
-                //code length 0-15
-                codewords_vec.push_back(code_index);
-                --codes_length_total;
-            } else if(code_index==16)
-            {
-                //this code reads previous code length 3-6 times (2 extra bits to read)
-                const int read_length = read_forward(input_vec, pos, 2) + 3;
-                codewords_vec.insert(codewords_vec.end(), read_length, codewords_vec[codewords_vec.size()-1]);
-                codes_length_total -= read_length;
-            } else if(code_index==17)
-            {
-                //this code copies 0 code 3-10 times (3 extra bits to read)
-                const int read_length = read_forward(input_vec, pos, 3) + 3;
-                codewords_vec.insert(codewords_vec.end(), read_length, 0);
-                codes_length_total -= read_length;
-            } else
+            _writer.write(last|(2<<1), 3);
+
+            _writer.write(plan.literals_used-257, 5);
+            _writer.write(plan.distances_used-1, 5);
+            _writer.write(plan.length_codes_used-4, 4);
+
+            for(int i = 0; i < plan.length_codes_used; ++i)
+                _writer.write(plan.length_code_lengths[length_codes_order[i]], 3);
+
+            const std::vector<uint16_t> length_codes = huffman_codes(plan.length_code_lengths);
+            for(const unsigned symbol : plan.length_symbols)
             {
-                //this code copies 0 code 11-138 times (7 extra bits to read)
-                const int read_length = read_forward(input_vec, pos, 7) + 11;
-                codewords_vec.insert(codewords_vec.end(), read_length, 0);
-                codes_length_total -= read_length;
+                const uint8_t code = symbol&0xff;
+                _writer.write(length_codes[code], plan.length_code_lengths[code]);
+
+                if(code>=16)
+                    _writer.write(symbol>>8, repeat_extra[code]);
             }
 
-            currcode_length = 0;
-            reading_bits = 0;
+            emit_codes(huffman_codes(plan.literal_lengths).data(), plan.literal_lengths.data(),
+                huffman_codes(plan.distance_lengths).data(), plan.distance_lengths.data());
         }
     }
 
-    const prefix_vector ret_vec = lengths_to_prefix(codewords_vec);
-    const std::vector<int> codewords_code_vec = ret_vec.vec;
-    const uint8_t max_codeword_code_length = ret_vec.highest_length;
+    _symbols.clear();
+    _literal_freqs.fill(0);
+    _distance_freqs.fill(0);
 
-    //copy pasting :(
-    std::vector<int> distance_code_temp;
-    reading_bits = 0;
-    currcode_length = 0;
-    for(;codes_distance_total!=0; reading_bits <<= 1)
+    _block_start = _pos;
+}
+
+void ydeflate::deflater::emit_stored(const uint8_t* data, size_t size, const bool last)
+{
+    do
     {
-        reading_bits |= (input_vec[pos.byte]>>pos.bit)&0x1;
-        shift_offset(pos);
-        ++currcode_length;
+        const unsigned block_size = std::min(size, static_cast<size_t>(0xffff));
+        const bool last_piece = block_size==size;
+
+        _writer.write(last && last_piece, 3);
+        _writer.align_byte();
+
+        _writer.write(block_size, 16);
+        _writer.write(block_size^0xffff, 16);
+
+        _writer.data.insert(_writer.data.end(), data, data+block_size);
+
+        data += block_size;
+        size -= block_size;
+    } while(size!=0);
+}
 
-        int code_index = lci_size;
-        for(int lci = 0; lci < lci_size; ++lci)
+void ydeflate::deflater::emit_codes(const uint16_t* literal_codes, const int* literal_lengths,
+    const uint16_t* distance_codes, const int* distance_lengths)
+{
+    for(const uint32_t symbol : _symbols)
+    {
+        if(symbol<256)
         {
-            if(length_codes_bin[lci]==reading_bits)
-            {
-                code_index = lci;
-                break;
-            }
+            _writer.write(literal_codes[symbol], literal_lengths[symbol]);
+            continue;
         }
 
-        if(code_index<19 && length_codes_vec[code_index]==currcode_length)
-        {
-            int read_length = 0;
-            if(code_index<16)
-            {
-                //code length 0-15
-                distance_code_temp.push_back(code_index);
-                --codes_distance_total;
-            } else if(code_index==16)
-            {
-                //this code reads previous code length 3-6 times (2 extra bits to read)
-                read_length = read_forward(input_vec, pos, 2);
-                read_length += 0x3;
+        const unsigned length = symbol&0xffff;
+        const unsigned distance = symbol>>16;
 
-                distance_code_temp.insert(distance_code_temp.end(),
-                                         read_length, distance_code_temp[distance_code_temp.size()-1]);
+        const uint8_t length_symbol = length_index(length);
+        const uint8_t distance_symbol = distance_index(distance);
 
-                codes_distance_total -= read_length;
-            } else if(code_index==17)
-            {
-                //this code copies 0 code 3-10 times (3 extra bits to read)
-                read_length = read_forward(input_vec, pos, 3);
-                read_length += 0x3;
+        _writer.write(literal_codes[257+length_symbol], literal_lengths[257+length_symbol]);
+        _writer.write(length-length_base[length_symbol], length_extra[length_symbol]);
 
-                distance_code_temp.insert(distance_code_temp.end(), read_length, 0);
+        _writer.write(distance_codes[distance_symbol], distance_lengths[distance_symbol]);
+        _writer.write(distance-distance_base[distance_symbol], distance_extra[distance_symbol]);
+    }
 
-                codes_distance_total -= read_length;
-            } else
-            {
-                //this code copies 0 code 11-138 times (7 extra bits to read)
-                read_length = read_forward(input_vec, pos, 7);
-                read_length += 0xb;
+    _writer.write(literal_codes[256], literal_lengths[256]);
+}
 
-                distance_code_temp.insert(distance_code_temp.end(), read_length, 0);
+void ydeflate::bit_writer::write(const uint32_t bits, const uint8_t num)
+{
+    _buffer |= static_cast<uint64_t>(bits)<<_count;
+    _count += num;
 
-                codes_distance_total -= read_length;
-            }
+    if(_count>=32)
+    {
+        const uint32_t word = _buffer;
+        data.push_back(word&0xff);
+        data.push_back((word>>8)&0xff);
+        data.push_back((word>>16)&0xff);
+        data.push_back(word>>24);
+
+        _buffer >>= 32;
+        _count -= 32;
+    }
+}
 
-            currcode_length = 0;
-            reading_bits = 0;
-        }
+void ydeflate::bit_writer::align_byte()
+{
+    for(; _count>0; _count -= std::min(_count, static_cast<uint8_t>(8)))
+    {
+        data.push_back(_buffer&0xff);
+        _buffer >>= 8;
     }
+}
+
+uint32_t ydeflate::adler32(const uint32_t adler, const uint8_t* data, const size_t size) noexcept
+{
+    typedef uint32_t (*adler_func)(uint32_t, const uint8_t*, size_t);
 
-    const std::vector<int> distance_code_length_vec = distance_code_temp;
+#if defined(__x86_64__) || defined(__i386__)
+    static const adler_func best_adler = __builtin_cpu_supports("avx2") ? adler32_avx2
+        : __builtin_cpu_supports("ssse3") ? adler32_ssse3 : adler32_scalar;
+#else
+    static const adler_func best_adler = adler32_scalar;
+#endif
 
-    const prefix_vector temp_ret_vec = lengths_to_prefix(distance_code_temp);
-    const std::vector<int> distance_code_vec = temp_ret_vec.vec;
-    const uint8_t max_distance_code_length = temp_ret_vec.highest_length;
+    return best_adler(adler, data, size);
+}
 
-    const int cv_size = codewords_code_vec.size();
+uint32_t ydeflate::adler32_scalar(uint32_t adler, const uint8_t* data, size_t size) noexcept
+{
+    const uint32_t adler_mod = 65521;
+    //most bytes that can be summed before the second sum can overflow
+    const size_t max_run = 5552;
 
-    std::vector<uint_fast8_t> codewords_length_code_size(max_codeword_code_length+1);
-    std::vector<std::vector<uint_fast16_t>> codewords_length_code_lookup(max_codeword_code_length+1);
+    uint32_t adler_sum1 = adler&0xffff;
+    uint32_t adler_sum2 = adler>>16;
 
-    codewords_length_code_size[0] = 0;
-    codewords_length_code_lookup[0] = std::vector<uint_fast16_t>();
-    for(int clci = 1; clci <= max_codeword_code_length; ++clci)
+    while(size!=0)
     {
-        std::vector<uint_fast16_t> inner_vec;
-        for(int clcii = 0; clcii < cv_size; ++clcii)
+        const size_t run = std::min(size, max_run);
+        for(size_t i = 0; i < run; ++i)
         {
-            if(codewords_vec[clcii]==clci)
-            {
-                inner_vec.push_back(clcii);
-            }
+            adler_sum1 += data[i];
+            adler_sum2 += adler_sum1;
         }
 
-        codewords_length_code_size[clci] = static_cast<uint_fast8_t>(inner_vec.size());
-        codewords_length_code_lookup[clci] = inner_vec;
+        adler_sum1 %= adler_mod;
+        adler_sum2 %= adler_mod;
+
+        data += run;
+        size -= run;
     }
 
-    const int dcv_size = distance_code_length_vec.size();
+    return (adler_sum2<<16)|adler_sum1;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("ssse3")))
+uint32_t ydeflate::adler32_ssse3(uint32_t adler, const uint8_t* data, size_t size) noexcept
+{
+    const uint32_t adler_mod = 65521;
+    //same limit as the scalar version, in 32 byte blocks
+    const size_t max_blocks = 5552/32;
+
+    uint32_t adler_sum1 = adler&0xffff;
+    uint32_t adler_sum2 = adler>>16;
 
-    std::vector<std::vector<uint_fast16_t>> distance_length_code_lookup(max_distance_code_length+1);
+    //each byte adds to the second sum once for every byte after it, so weights go down to 1
+    const __m128i weights_low = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i weights_high = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i zero = _mm_setzero_si128();
 
-    distance_length_code_lookup[0] = std::vector<uint_fast16_t>();
-    for(int dlci = 1; dlci <= max_distance_code_length; ++dlci)
+    size_t blocks = size/32;
+    size -= blocks*32;
+
+    while(blocks!=0)
     {
-        std::vector<uint_fast16_t> inner_vec;
-        for(int dlcii = 0; dlcii < dcv_size; ++dlcii)
+        const size_t run = std::min(blocks, max_blocks);
+        blocks -= run;
+
+        //the first sum as it was before each block, added 32 times to the second sum at the end
+        __m128i previous_sums = _mm_cvtsi32_si128(adler_sum1*run);
+        __m128i sums1 = zero;
+        __m128i sums2 = _mm_cvtsi32_si128(adler_sum2);
+
+        for(size_t i = 0; i < run; ++i, data += 32)
         {
-            if(distance_code_length_vec[dlcii]==dlci)
-            {
-                inner_vec.push_back(dlcii);
-            }
+            const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data+16));
+
+            previous_sums = _mm_add_epi32(previous_sums, sums1);
+
+            sums1 = _mm_add_epi32(sums1, _mm_sad_epu8(low, zero));
+            sums1 = _mm_add_epi32(sums1, _mm_sad_epu8(high, zero));
+
+            sums2 = _mm_add_epi32(sums2, _mm_madd_epi16(_mm_maddubs_epi16(low, weights_low), ones));
+            sums2 = _mm_add_epi32(sums2, _mm_madd_epi16(_mm_maddubs_epi16(high, weights_high), ones));
         }
 
-        distance_length_code_lookup[dlci] = inner_vec;
+        sums2 = _mm_add_epi32(sums2, _mm_slli_epi32(previous_sums, 5));
+
+        sums1 = _mm_add_epi32(sums1, _mm_shuffle_epi32(sums1, _MM_SHUFFLE(1, 0, 3, 2)));
+        sums2 = _mm_add_epi32(sums2, _mm_shuffle_epi32(sums2, _MM_SHUFFLE(2, 3, 0, 1)));
+        sums2 = _mm_add_epi32(sums2, _mm_shuffle_epi32(sums2, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        adler_sum1 = (adler_sum1+_mm_cvtsi128_si32(sums1))%adler_mod;
+        adler_sum2 = _mm_cvtsi128_si32(sums2)%adler_mod;
     }
 
-    uint_fast8_t currcode_length_l = 0;
-    uint_fast16_t reading_bits_l = 0;
+    return adler32_scalar((adler_sum2<<16)|adler_sum1, data, size);
+}
 
-    for(;; reading_bits_l <<= 1)
-    {
-        reading_bits_l |= (input_vec[pos.byte]>>pos.bit)&0x1;
+__attribute__((target("avx2")))
+uint32_t ydeflate::adler32_avx2(uint32_t adler, const uint8_t* data, size_t size) noexcept
+{
+    const uint32_t adler_mod = 65521;
+    const size_t max_blocks = 5552/32;
 
-        ++pos.bit;
-        if(((pos.bit)&0x8)>>3)
-        {
-            ++pos.byte;
-            pos.bit &= 0x7;
-        }
-        ++currcode_length_l;
+    uint32_t adler_sum1 = adler&0xffff;
+    uint32_t adler_sum2 = adler>>16;
 
-        int_fast16_t code_index = cv_size;
+    const __m256i weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+        16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i zero = _mm256_setzero_si256();
 
-        const uint_fast8_t c_len_lookup_length = codewords_length_code_size[currcode_length_l];
-        for(uint_fast8_t cci = 0; cci < c_len_lookup_length; ++cci)
-        {
-            if(codewords_code_vec[codewords_length_code_lookup[currcode_length_l][cci]]==reading_bits_l)
-            {
-                code_index = codewords_length_code_lookup[currcode_length_l][cci];
-                break;
-            }
-        }
+    size_t blocks = size/32;
+    size -= blocks*32;
 
-        if(code_index!=cv_size)
-        {
-            if(code_index<256)
-            {
-                data_vec.push_back(static_cast<uint8_t>(code_index));
-            } else
-            {
-                if(code_index==256)
-                    break;
+    while(blocks!=0)
+    {
+        const size_t run = std::min(blocks, max_blocks);
+        blocks -= run;
 
-                const int read_length = huffman_length(input_vec, pos, code_index);
+        __m256i previous_sums = _mm256_setr_epi32(adler_sum1*run, 0, 0, 0, 0, 0, 0, 0);
+        __m256i sums1 = zero;
+        __m256i sums2 = _mm256_setr_epi32(adler_sum2, 0, 0, 0, 0, 0, 0, 0);
 
-                uint8_t c_inner_bits_length = 0;
-                int temp_distance = 0;
-                for(;; temp_distance <<= 1)
-                {
-                    temp_distance |= (input_vec[pos.byte]>>pos.bit)&0x1;
-                    shift_offset(pos);
-                    ++c_inner_bits_length;
+        for(size_t i = 0; i < run; ++i, data += 32)
+        {
+            const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
 
-                    int distance_index = dcv_size;
+            previous_sums = _mm256_add_epi32(previous_sums, sums1);
 
-                    const int c_len_lookup_length = distance_length_code_lookup[c_inner_bits_length].size();
-                    for(int dci = 0; dci < c_len_lookup_length; ++dci)
-                    {
-                        if(distance_code_vec[distance_length_code_lookup[c_inner_bits_length][dci]]==temp_distance)
-                        {
-                            distance_index = distance_length_code_lookup[c_inner_bits_length][dci];
-                            break;
-                        }
-                    }
+            sums1 = _mm256_add_epi32(sums1, _mm256_sad_epu8(bytes, zero));
+            sums2 = _mm256_add_epi32(sums2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, weights), ones));
+        }
 
-                    if(distance_index!=dcv_size)
-                    {
-                        temp_distance = distance_index;
-                        break;
-                    }
-                }
+        sums2 = _mm256_add_epi32(sums2, _mm256_slli_epi32(previous_sums, 5));
 
-                const int read_distance = huffman_distance(input_vec, pos, temp_distance);
+        //8 lanes down to 1
+        const auto lanes_sum = [](const __m256i sums) __attribute__((target("avx2")))
+        {
+            __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
 
-                data_vec.reserve(read_length);
-                const unsigned deflate_data_end = data_vec.size();
-                for(int rb = 0; rb < read_length; ++rb)
-                {
-                    data_vec.emplace_back(data_vec[deflate_data_end-read_distance+rb]);
-                }
-            }
+            return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+        };
 
-            currcode_length_l = 0;
-            reading_bits_l = 0;
-        }
+        adler_sum1 = (adler_sum1+lanes_sum(sums1))%adler_mod;
+        adler_sum2 = lanes_sum(sums2)%adler_mod;
     }
+
+    return adler32_scalar((adler_sum2<<16)|adler_sum1, data, size);
+}
+#else
+uint32_t ydeflate::adler32_ssse3(uint32_t adler, const uint8_t* data, size_t size) noexcept
+{
+    return adler32_scalar(adler, data, size);
 }
 
-int ydeflate::huffman_distance(const std::vector<uint8_t>& input_vec, f_pos& pos, int input_bits)
+uint32_t ydeflate::adler32_avx2(uint32_t adler, const uint8_t* data, size_t size) noexcept
 {
-    const int extra_distance_bits = std::max(0, (input_bits-0x2)) / 2;
+    return adler32_scalar(adler, data, size);
+}
+#endif
 
-    const int mover_val = input_bits-5;
+std::array<uint8_t, 2> ydeflate::zlib_header(const int level) noexcept
+{
+    const uint8_t compression_method = 8; //the only one that exists atm
+    const uint8_t compression_info = 7; //32kb window
 
-    const int loop_range = mover_val/2+1;
-    for(int mli = 0; mli < loop_range; ++mli)
-    {
-        input_bits += (mover_val+1-(2*mli))*(1<<mli);
-    }
+    const uint8_t cmf_data = (compression_info<<4)|(compression_method&0x0f);
 
-    ++input_bits;
+    const uint8_t dict_set = 0;
+    //0 - fastest, 1 - fast, 2 - default, 3 - slowest
+    const uint8_t compression_level = level<2 ? 0 : level<6 ? 1 : level==6 ? 2 : 3;
 
-    for(int ext = 0; ext < extra_distance_bits; ++ext)
-    {
-        input_bits += ((input_vec[pos.byte]>>pos.bit)&0x1)<<ext;
-        shift_offset(pos);
-    }
+    uint8_t flg_data = ((compression_level&0x3)<<6)|((dict_set&0x1)<<5);
+
+    //has to be that (cmf_data*256 + flg_data) % 31 == 0
+    const uint8_t check_remainder = (static_cast<int>(cmf_data)*256+static_cast<int>(flg_data))%31;
+    if(check_remainder!=0)
+        flg_data |= (31-check_remainder)&0x1f;
 
-    return input_bits;
+    return {cmf_data, flg_data};
 }
 
-int ydeflate::huffman_length(const std::vector<uint8_t>& input_vec, f_pos& pos, const int input_bits)
+uint32_t ydeflate::adler32_combine(const uint32_t first, const uint32_t second, const size_t second_size) noexcept
 {
-    const int extra_length_bits = std::max(0, (input_bits-0x105)) / 4;
-    switch(extra_length_bits)
-    {
-        case 0:
-            return input_bits-0xfe;
+    const uint32_t adler_mod = 65521;
 
-        case 6:
-            return 258;
+    const uint32_t remainder = second_size%adler_mod;
 
-        default:
-            const int mover_val = input_bits-0x10a;
-            const int loop_range = mover_val/4+1;
+    //the first sum carries through every byte of the second piece
+    uint32_t adler_sum1 = first&0xffff;
+    uint32_t adler_sum2 = (remainder*adler_sum1)%adler_mod;
 
-            int read_length = std::max(0, input_bits-0xfe);
-            for(int mli = 0; mli < loop_range; ++mli)
-            {
-                read_length += (mover_val+1-(4*mli))*(1<<mli);
-            }
+    adler_sum1 += (second&0xffff)+adler_mod-1;
+    adler_sum2 += (first>>16)+(second>>16)+adler_mod-remainder;
 
-            for(int ext = 0; ext < extra_length_bits; ++ext)
-            {
-                read_length += ((input_vec[pos.byte]>>pos.bit)&0x1)<<ext;
-                shift_offset(pos);
-            }
+    if(adler_sum1>=adler_mod)
+        adler_sum1 -= adler_mod;
+    if(adler_sum1>=adler_mod)
+        adler_sum1 -= adler_mod;
 
-            return read_length;
-    }
+    if(adler_sum2>=adler_mod*2)
+        adler_sum2 -= adler_mod*2;
+    if(adler_sum2>=adler_mod)
+        adler_sum2 -= adler_mod;
+
+    return (adler_sum2<<16)|adler_sum1;
 }
 
-void ydeflate::shift_offsets(f_pos& pos, int num)
+uint8_t ydeflate::length_index(const unsigned length) noexcept
 {
-    pos.bit += num;
-    if(pos.bit>7)
+    static constexpr std::array<uint8_t, 259> indices = []()
     {
-        ++pos.byte;
-        pos.bit &= 0x7;
-    }
-}
+        std::array<uint8_t, 259> indices{};
+        for(size_t i = 0; i < length_base.size(); ++i)
+        {
+            for(size_t length = length_base[i]; length < indices.size(); ++length)
+                indices[length] = i;
+        }
 
-void ydeflate::shift_offset(f_pos& pos)
-{
-    ++pos.bit;
-    pos.byte += ((pos.bit)&0x8)>>3;
-    pos.bit &= 0x7;
-}
+        return indices;
+    }();
 
-int ydeflate::read_forward(const std::vector<uint8_t>& input_vec, f_pos& pos, int num)
-{
-    const int ret_val =
-    ((((input_vec[pos.byte]>>pos.bit)&((2<<(num-1))-1))
-    | ((input_vec[pos.byte+1]<<(8-pos.bit))&((2<<(num-1))-1))));
-    shift_offsets(pos, num);
-    return ret_val;
+    return indices[length];
 }
 
-std::vector<uint8_t> ydeflate::inflate(const std::vector<uint8_t>& input_data)
+uint8_t ydeflate::distance_index(const unsigned distance) noexcept
 {
-    std::vector<uint8_t> inflated_data;
-
-    const uint8_t compression_method = 8; //the only one that exists atm
-    const uint8_t compression_info = 7; //max window size, not even gonna try calculating it properly
+    //distances up to 256 directly, past that in steps of 128 which no base splits
+    static constexpr std::array<uint8_t, 512> indices = []()
+    {
+        std::array<uint8_t, 512> indices{};
+        for(size_t i = 0; i < distance_base.size(); ++i)
+        {
+            for(unsigned distance = distance_base[i]; distance < distance_base[i]+(1u<<distance_extra[i]); ++distance)
+            {
+                const unsigned start = distance-1;
+                indices[start<256 ? start : 256+(start>>7)] = i;
+            }
+        }
 
-    const uint8_t cmf_data = (compression_info<<4)|(compression_method&0x0f);
-    inflated_data.push_back(cmf_data);
+        return indices;
+    }();
 
-    uint8_t check_val = 0; //has to be that (cmf_data*256 + flg_data) % 31 == 0
-    const uint8_t dict_set = 0; //i dont know how enabling it helps me in any way
-    const uint8_t compression_level = 0; //i clearly used the least compressed one there is because its made by me
+    const unsigned start = distance-1;
+    return indices[start<256 ? start : 256+(start>>7)];
+}
 
-    uint8_t flg_data = ((compression_level&0x3)<<6)|((dict_set&0x1)<<5)|(check_val&0x1f);
+std::vector<int> ydeflate::huffman_lengths(const unsigned* freqs, const size_t count, const uint8_t max_length)
+{
+    std::vector<int> lengths_vec(count, 0);
 
-    const uint8_t crc_remainder = (static_cast<int>(cmf_data)*256+static_cast<int>(flg_data))%31;
-    //make it mod 31 == 0
-    if(crc_remainder!=0)
+    std::vector<int> used_symbols;
+    for(size_t i = 0; i < count; ++i)
     {
-        flg_data |= (31-crc_remainder)&0x1f;
+        if(freqs[i]!=0)
+            used_symbols.push_back(i);
     }
-    inflated_data.push_back(flg_data);
 
-    bool last_block = false;
+    if(used_symbols.size()<2)
+    {
+        //a single code still needs one bit
+        for(const int symbol : used_symbols)
+            lengths_vec[symbol] = 1;
 
-    const int max_distance = 32768;
+        return lengths_vec;
+    }
 
-    for(int i = 0; !last_block;)
-    {
-        //0 = no compression
-        //1 = static huffman tree
-        //2 = dynamic huffman tree
-        const uint8_t encoding_method = 0;
+    //build the tree, leaves are 0..n-1 and inner nodes come after them
+    const int leaves = used_symbols.size();
+    std::vector<int> parents(leaves*2-1, -1);
 
-        const int block_size = std::min(static_cast<int>(input_data.size()-i), 0xffff);
+    typedef std::pair<uint64_t, int> node_type;
+    std::priority_queue<node_type, std::vector<node_type>, std::greater<node_type>> nodes;
 
-        const int next_block_edge = i+block_size;
+    for(int i = 0; i < leaves; ++i)
+        nodes.emplace(freqs[used_symbols[i]], i);
 
-        int max_bound = next_block_edge;
-        if(next_block_edge >= input_data.size())
-        {
-            last_block = true;
-            max_bound = input_data.size();
-        }
+    for(int next_node = leaves; nodes.size()>1; ++next_node)
+    {
+        const node_type left = nodes.top();
+        nodes.pop();
+        const node_type right = nodes.top();
+        nodes.pop();
 
-        const uint8_t bit_info = ((encoding_method&0x3)<<1)|(static_cast<uint8_t>(last_block));
+        parents[left.second] = next_node;
+        parents[right.second] = next_node;
 
-        switch(encoding_method)
-        {
-            case 0:
-            {
-                inflated_data.push_back(bit_info);
+        nodes.emplace(left.first+right.first, next_node);
+    }
 
-                //block length
-                inflated_data.push_back(block_size&0xff);
-                inflated_data.push_back((block_size&0xff00)>>8);
+    //count how many codes have each length, the root is the last node
+    std::vector<int> depths(leaves*2-1, 0);
+    std::vector<int> length_counts(std::max(leaves, static_cast<int>(max_length))+1, 0);
+    for(int node = leaves*2-3; node >= 0; --node)
+    {
+        depths[node] = depths[parents[node]]+1;
 
-                //ones complement of block length
-                inflated_data.push_back((block_size&0xff)^0xff);
-                inflated_data.push_back(((block_size&0xff00)>>8)^0xff);
+        if(node<leaves)
+            ++length_counts[depths[node]];
+    }
 
-                inflated_data.reserve(block_size);
-                for(;i < max_bound; ++i)
-                {
-                    inflated_data.emplace_back(input_data[i]);
-                }
-                break;
-            }
+    //move codes that are too long up while keeping the code complete
+    for(int i = length_counts.size()-1; i > max_length; --i)
+    {
+        while(length_counts[i]>0)
+        {
+            int j = i-2;
+            while(length_counts[j]==0)
+                --j;
+
+            length_counts[i] -= 2;
+            ++length_counts[i-1];
+            length_counts[j+1] += 2;
+            --length_counts[j];
         }
     }
 
-    const uint32_t adler_mod = 65521;
-
-    uint32_t adler_sum1 = 1;
-    uint32_t adler_sum2 = 0;
+    //the most frequent symbols get the shortest codes
+    std::stable_sort(used_symbols.begin(), used_symbols.end(), [freqs](int l, int r){return freqs[l]>freqs[r];});
 
-    //how inefficient ;-;
-    //dont care
-    for(const auto& byte : input_data)
+    int symbol_index = 0;
+    for(int length = 1; length <= max_length; ++length)
     {
-        adler_sum1 = (adler_sum1 + byte) % adler_mod;
-        adler_sum2 = (adler_sum2 + adler_sum1) % adler_mod;
+        for(int c = 0; c < length_counts[length]; ++c, ++symbol_index)
+            lengths_vec[used_symbols[symbol_index]] = length;
     }
 
-    inflated_data.push_back((adler_sum2&0xff00)>>8);
-    inflated_data.push_back(adler_sum2&0xff);
+    return lengths_vec;
+}
+
+std::vector<uint16_t> ydeflate::huffman_codes(const std::vector<int>& lengths_vec)
+{
+    const std::vector<int> codes_vec = lengths_to_prefix(lengths_vec).vec;
+
+    std::vector<uint16_t> reversed_codes(lengths_vec.size(), 0);
 
-    inflated_data.push_back((adler_sum1&0xff00)>>8);
-    inflated_data.push_back(adler_sum1&0xff);
+    const int lengths_size = lengths_vec.size();
+    for(int i = 0; i < lengths_size; ++i)
+    {
+        if(lengths_vec[i]!=0)
+            reversed_codes[i] = reverse_bits(codes_vec[i], lengths_vec[i]);
+    }
 
-    return inflated_data;
+    return reversed_codes;
 }
 
 template <typename T>
@@ -1825,7 +6779,8 @@ ydeflate::prefix_vector ydeflate::lengths_to_prefix(const std::vector<int>& leng
 {
     const int max_val = INT_MAX; //hardcoded, who cares
 
-    std::vector<uint8_t> counts_vec(lengths_vec.size(), 0);
+    //deflate codes are at most 15 bits long
+    std::vector<int> counts_vec(16, 0);
 
     uint8_t max_bit_length = 0;
     for(const auto& c_length : lengths_vec)
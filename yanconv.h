@@ -2,8 +2,13 @@
 #define YANCONV_H
 
 #include <vector>
+#include <array>
 #include <string>
+#include <cstdint>
+#include <cstddef>
 #include <filesystem>
+#include <ostream>
+#include <future>
 
 //everything written by 57qr53r3dn4y to reinvent the wheel (and very poorly)
 
@@ -11,24 +16,113 @@ namespace yconv
 {
 	std::vector<std::string> string_split(std::string text, const std::string delimeter);
 
+	//read only view of a whole file, mapped into memory instead of read
+	class mapped_file
+	{
+	public:
+		mapped_file(const std::filesystem::path path);
+		~mapped_file();
+
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		const uint8_t* data() const noexcept;
+		size_t size() const noexcept;
+
+	private:
+		const uint8_t* _data = nullptr;
+		size_t _size = 0;
+	};
+
+	//what the alpha channel of an image holds, opaque if there is none
+	enum class alpha_type {opaque, binary, translucent};
+
+	//whats known about an image from its header alone
+	struct image_info
+	{
+		unsigned width = 0;
+		unsigned height = 0;
+
+		//channels of the decoded image
+		uint8_t channels = 0;
+		uint8_t bit_depth = 8;
+
+		bool pallete = false;
+		bool transparency = false;
+		bool interlaced = false;
+	};
+
+	//how each mip level gets filtered down from the one before
+	//box averages the pixels it covers, kaiser is a wider windowed sinc that keeps more detail
+	enum class mip_filter {box, kaiser};
+
+	class mip_chain;
+	class image;
+
+	//pixels owned by something else, rows can be further apart than a row is long
+	//or go backwards with a negative stride
+	struct image_view
+	{
+		image_view() {};
+		//a stride of 0 means the rows come right after each other
+		image_view(const uint8_t* data, const unsigned width, const unsigned height, const uint8_t bpp,
+			const std::ptrdiff_t stride = 0) noexcept;
+		image_view(const image& img) noexcept;
+
+		const uint8_t* row(const unsigned y) const noexcept;
+		//in bytes, without the gap to the next one
+		size_t row_size() const noexcept;
+		bool contiguous() const noexcept;
+
+		//width by height pixels starting at x and y
+		image_view crop(const unsigned x, const unsigned y, const unsigned width, const unsigned height) const noexcept;
+		//the last row first
+		image_view flipped() const noexcept;
+
+		const uint8_t* data = nullptr;
+
+		unsigned width = 0;
+		unsigned height = 0;
+		uint8_t bpp = 0;
+
+		//bytes from the start of one row to the start of the next
+		std::ptrdiff_t stride = 0;
+	};
+
 	class image
 	{
 	public:
-		enum class resize_type {nearest_neighbor, area_sample};
+		//bilinear, the cubics and lanczos widen with the scale when downscaling so every source pixel counts
+		//catmull_rom is the sharper cubic, mitchell the one with less ringing
+		enum class resize_type {nearest_neighbor, area_sample, bilinear, catmull_rom, mitchell, lanczos};
 
 		image();
 		image(const std::filesystem::path image_path);
-		image(const unsigned width, const unsigned height, const uint8_t bpp, const std::vector<uint8_t> data);
+		image(const unsigned width, const unsigned height, const uint8_t bpp, const std::vector<uint8_t>& data);
+		image(const unsigned width, const unsigned height, const uint8_t bpp, std::vector<uint8_t>&& data) noexcept;
+		//copies the pixels into rows right after each other
+		explicit image(const image_view view);
+
+		image_view view() const noexcept;
 
 		void bpp_resize(const uint8_t bpp, const uint8_t extra_channel=255);
 
-		void resize(const unsigned width, const unsigned height, const resize_type type);
-		void flip();
+		//more than 1 thread splits the rows between threads, 0 uses every core
+		void resize(const unsigned width, const unsigned height, const resize_type type, const unsigned threads_num = 1);
+		//swaps the rows in place
+		void flip() noexcept;
 
 		void grayscale();
 
+		//every level halved down to 1x1, see mip_chain
+		mip_chain mipmaps(const mip_filter filter = mip_filter::box, const bool srgb = true,
+			const unsigned threads_num = 1) const;
+
 		bool read(const std::filesystem::path load_path);
 		bool save(const std::filesystem::path save_path) const;
+
+		//reads only the header, false if the format isnt supported
+		static bool probe(const std::filesystem::path load_path, image_info& info);
 		
 		unsigned pixel_color_pos(const unsigned x, const unsigned y, const uint8_t color) const noexcept;
 		uint8_t pixel_color(const unsigned x, const unsigned y, const uint8_t color) const noexcept;
@@ -43,88 +137,599 @@ namespace yconv
 		std::vector<uint8_t> data;
 	};
 
-	namespace png
+	//conversions over runs of pixels, each one picks an avx2, sse2 or scalar version at runtime
+	namespace pixels
 	{
-		image read(const std::filesystem::path load_path);
-		void save(const image& img, const std::filesystem::path save_path);
+		//keeps the channels both have and fills the new ones with fill, like bpp_resize
+		void copy_channels(const uint8_t* in, const uint8_t in_channels, uint8_t* out, const uint8_t out_channels,
+			const size_t count, const uint8_t fill) noexcept;
+		template<int in_channels, int out_channels>
+		void copy_channels_scalar(const uint8_t* in, uint8_t* out, const size_t count, const uint8_t fill) noexcept;
 
-		std::vector<char> create_chunk(const image& img, const std::string name);
-		void chunk_header(const std::string name, std::vector<char>& write_data) noexcept;
-		void chunk_ending(std::vector<char>& write_data) noexcept;
+		//rec 601 luma of the colors as one channel, alpha gets dropped and gray stays the same
+		void luminance(const uint8_t* in, const uint8_t channels, uint8_t* out, const size_t count) noexcept;
+		template<int channels>
+		void luminance_scalar(const uint8_t* in, uint8_t* out, const size_t count) noexcept;
+		//only rgba
+		void luminance_sse2(const uint8_t* in, uint8_t* out, const size_t count) noexcept;
+		void luminance_avx2(const uint8_t* in, uint8_t* out, const size_t count) noexcept;
 
-		typedef std::vector<uint8_t> storage_type;
-		std::vector<char> create_data(const storage_type& data_bytes, storage_type::const_iterator iter_start);
+		//rgba colors times alpha/255 rounded to nearest, in place
+		void premultiply(uint8_t* data, const size_t count) noexcept;
+		void premultiply_scalar(uint8_t* data, const size_t count) noexcept;
+		void premultiply_sse2(uint8_t* data, const size_t count) noexcept;
+		void premultiply_avx2(uint8_t* data, const size_t count) noexcept;
 
-		void emplace_line(const image& img, const uint8_t filter, const int line, storage_type& out) noexcept;
+		//rgba colors times 255/alpha rounded to nearest and clamped, fully transparent ones become black
+		void unpremultiply(uint8_t* data, const size_t count) noexcept;
+		//a table lookup per color
+		void unpremultiply_scalar(uint8_t* data, const size_t count) noexcept;
+		//float division, it only has to be exact up to 255 so it always matches the table
+		void unpremultiply_sse2(uint8_t* data, const size_t count) noexcept;
+		void unpremultiply_avx2(uint8_t* data, const size_t count) noexcept;
 
-		struct filter_values
+		//true at the first alpha below 255, channels has to be 2 or 4
+		bool has_transparency(const uint8_t* data, const uint8_t channels, const size_t count) noexcept;
+		bool has_transparency_scalar(const uint8_t* data, const uint8_t channels, const size_t count) noexcept;
+		bool has_transparency_sse2(const uint8_t* data, const uint8_t channels, const size_t count) noexcept;
+		bool has_transparency_avx2(const uint8_t* data, const uint8_t channels, const size_t count) noexcept;
+	};
+
+	//separable resizing, a row pass and a column pass each reading their weights from a table
+	namespace resample
+	{
+		//fractional bits of the fixed point weights
+		constexpr int weight_bits = 14;
+
+		//output pixel i reads taps source pixels from starts[i], weights holds taps weights for each one
+		//every pixels weights add up to exactly 1<<weight_bits
+		struct weight_table
 		{
-			unsigned index;
-			unsigned width;
-			int x;
-			int y;
-			uint8_t bpp;
+			unsigned taps = 0;
+
+			std::vector<unsigned> starts;
+			std::vector<int16_t> weights;
 		};
-		uint8_t defilter_value(const std::vector<uint8_t>& data, const uint8_t filter, const uint8_t val, const filter_values f) noexcept;
-		uint8_t filter_value(const image& img, const uint8_t filter, const int x, const int y, const uint8_t col) noexcept;
-		uint8_t best_filter(const image& img, const int line) noexcept;
 
-		std::vector<uint32_t> crc_table_gen() noexcept;
+		//the weights of any type other than nearest_neighbor
+		weight_table weights(const unsigned source_size, const unsigned size, const image::resize_type type);
 
-		uint8_t paeth_predictor(const int left, const int up, const int up_left) noexcept;
+		//each output pixel averages the source pixels it covers, the partially covered ones by how much
+		weight_table area_weights(const unsigned source_size, const unsigned size);
+		//kernel centered on each output pixel, support is how far it reaches at a scale of 1
+		weight_table kernel_weights(const unsigned source_size, const unsigned size, const double support,
+			double (*kernel)(const double));
 
-		uint8_t modulo_sub(const int lval, const int rval) noexcept;
-		uint8_t modulo_add(const int lval, const int rval) noexcept;
-	};
+		double bilinear_kernel(const double x) noexcept;
+		//mitchell-netravali family of cubics, b and c pick the curve
+		double cubic_kernel(const double x, const double b, const double c) noexcept;
+		double catmull_rom_kernel(const double x) noexcept;
+		double mitchell_kernel(const double x) noexcept;
+		//3 lobes
+		double lanczos_kernel(const double x) noexcept;
 
-	namespace pgm
-	{
-		image read(const std::filesystem::path load_path);
-		void save(const image& img, const std::filesystem::path save_path);
-	};
+		//normalizes and rounds the weights, the first source pixel of output i is starts[i]
+		//starts get moved back so no pixel reads past the end of the source
+		weight_table fixed_weights(const unsigned source_size, const std::vector<unsigned>& starts,
+			const std::vector<std::vector<double>>& weights);
 
-	namespace ppm
-	{
-		void save(const image& img, const std::filesystem::path save_path);
+		//columns resizes the width, rows the height
+		//more than 1 thread splits each pass into bands of rows, 0 uses every core
+		image resize(const image_view& img, const weight_table& columns, const weight_table& rows,
+			const unsigned threads_num = 1);
+
+		//a band of rows of one of the passes
+		struct resample_job
+		{
+			//bytes, or 15 bit values if wide
+			const void* in;
+			void* out;
+			bool wide = false;
+
+			unsigned in_width;
+			unsigned out_width;
+			uint8_t channels;
+			//bytes from one input row to the next, only 8 bit passes read from views
+			std::ptrdiff_t in_stride = 0;
+
+			const weight_table* table;
+			//row pass if true, otherwise column pass
+			bool row_pass;
+
+			unsigned first_row;
+			unsigned end_row;
+
+			std::promise<void> done;
+		};
+		void resample_band(resample_job* job) noexcept;
+
+		//rows_num rows in_stride bytes apart into packed rows of out_width pixels
+		void row_pass(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out, const unsigned out_width,
+			const unsigned rows_num, const uint8_t channels, const weight_table& table) noexcept;
+		template<int channels>
+		void row_pass_scalar(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out,
+			const unsigned out_width, const unsigned rows_num, const weight_table& table) noexcept;
+		void row_pass_sse2(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out, const unsigned out_width,
+			const unsigned rows_num, const weight_table& table) noexcept;
+
+		//output rows from first_row up to end_row, each row is row_size bytes in both
+		//input rows are in_stride bytes apart, output rows are packed
+		void column_pass(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out, const size_t row_size,
+			const unsigned first_row, const unsigned end_row, const weight_table& table) noexcept;
+		void column_pass_scalar(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out,
+			const size_t row_size, const unsigned first_row, const unsigned end_row, const weight_table& table) noexcept;
+		void column_pass_sse2(const uint8_t* in, const std::ptrdiff_t in_stride, uint8_t* out,
+			const size_t row_size, const unsigned first_row, const unsigned end_row, const weight_table& table) noexcept;
+
+		//15 bit passes for data that needs more precision than a byte, like linear light
+		//values go from 0 to wide_max and come out clamped to it
+		constexpr int wide_max = 32767;
+
+		void row_pass_wide(const uint16_t* in, const unsigned in_width, uint16_t* out, const unsigned out_width,
+			const unsigned rows_num, const uint8_t channels, const weight_table& table) noexcept;
+		template<int channels>
+		void row_pass_wide_scalar(const uint16_t* in, const unsigned in_width, uint16_t* out,
+			const unsigned out_width, const unsigned rows_num, const weight_table& table) noexcept;
+		void row_pass_wide_sse2(const uint16_t* in, const unsigned in_width, uint16_t* out,
+			const unsigned out_width, const unsigned rows_num, const weight_table& table) noexcept;
+
+		void column_pass_wide(const uint16_t* in, uint16_t* out, const size_t row_size, const unsigned first_row,
+			const unsigned end_row, const weight_table& table) noexcept;
+		void column_pass_wide_scalar(const uint16_t* in, uint16_t* out, const size_t row_size,
+			const unsigned first_row, const unsigned end_row, const weight_table& table) noexcept;
+		void column_pass_wide_sse2(const uint16_t* in, uint16_t* out, const size_t row_size,
+			const unsigned first_row, const unsigned end_row, const weight_table& table) noexcept;
+
+		//kaiser windowed sinc with 3 lobes
+		double kaiser_kernel(const double x) noexcept;
+		//modified bessel function of the first kind, for the kaiser window
+		double bessel_i0(const double x) noexcept;
 	};
 
-	class model
+	//every level of an image halved down to 1x1, all of them one after another in a single allocation
+	class mip_chain
 	{
 	public:
-		model() {};
-		model(const std::filesystem::path model_path);
+		mip_chain() {};
+		//level 0 is the image itself
+		//srgb filters the color channels in linear light, alpha is always linear
+		//more than 1 thread splits the rows of each level between threads, 0 uses every core
+		mip_chain(const image_view& img, const mip_filter filter = mip_filter::box, const bool srgb = true,
+			const unsigned threads_num = 1);
 
-		bool read(const std::filesystem::path load_path);
+		size_t levels() const noexcept;
 
-		std::vector<float> vertices;
-		std::vector<int> indices;
+		unsigned width(const size_t level) const noexcept;
+		unsigned height(const size_t level) const noexcept;
+		uint8_t bpp() const noexcept;
+
+		const uint8_t* data(const size_t level) const noexcept;
+		//in bytes
+		size_t size(const size_t level) const noexcept;
+
+		//a copy of one level
+		image level(const size_t level) const;
+
+		bool empty() const noexcept;
 
 	private:
-		bool obj_read(const std::filesystem::path load_path);
+		struct level_info
+		{
+			unsigned width;
+			unsigned height;
+
+			size_t offset;
+		};
+
+		uint8_t _bpp = 0;
+
+		std::vector<level_info> _levels;
+		std::vector<uint8_t> _data;
 	};
 
 	namespace ydeflate
 	{
-		struct f_pos
+		//lsb first bit reader, refills a 64 bit buffer with one unaligned load
+		//input can be split in two parts so a leftover tail can continue into new data
+		class bit_reader
+		{
+		public:
+			bit_reader() {};
+			bit_reader(const uint8_t* data, const size_t size) noexcept;
+
+			//keeps the bits already in the buffer and continues reading from the new input
+			void set_input(const uint8_t* data, const size_t size,
+				const uint8_t* next_data = nullptr, const size_t next_size = 0) noexcept;
+			//appends every byte that wasnt loaded into the buffer yet
+			void take_remaining(std::vector<uint8_t>& out) const;
+
+			//at most 32 bits at a time
+			uint64_t peek(const uint8_t num) noexcept;
+			void consume(const uint8_t num) noexcept;
+			unsigned read(const uint8_t num) noexcept;
+
+			void align_byte() noexcept;
+			//copies whole bytes, the reader has to be byte aligned
+			void read_bytes(uint8_t* out, size_t num) noexcept;
+
+			size_t available_bits() const noexcept;
+
+			//true if more bits were consumed than the input had
+			bool overrun() const noexcept;
+
+		private:
+			void refill() noexcept;
+
+			const uint8_t* _pos = nullptr;
+			const uint8_t* _end = nullptr;
+
+			const uint8_t* _next_pos = nullptr;
+			const uint8_t* _next_end = nullptr;
+
+			uint64_t _buffer = 0;
+			uint8_t _count = 0;
+
+			//zero bytes added after the end of the input
+			size_t _padding = 0;
+		};
+
+		//canonical huffman decoder, codes up to primary_bits long resolve in one lookup
+		//and longer codes go through a second lookup in a sub-table
+		class huffman_table
+		{
+		public:
+			huffman_table() {};
+			huffman_table(const std::vector<int>& lengths_vec, const uint8_t primary_bits);
+
+			//returns -1 for codes that arent in the table
+			int decode(bit_reader& reader) const noexcept;
+
+		private:
+			//lowest 8 bits are the code length, 0x100 marks a link to a sub-table
+			//upper 16 bits are either the symbol or the sub-table offset
+			std::vector<uint32_t> _entries;
+			uint8_t _primary_bits = 0;
+		};
+
+		//resumable zlib stream decoder, input is fed in chunks and output is pulled into caller buffers
+		//only the last 32kb of output are kept around for back references
+		class inflater
+		{
+		public:
+			//verifying runs adler32 over the output and throws if it doesnt match the stream
+			inflater(const bool verify = false);
+
+			//the data is read in place and has to stay valid until read stops because of needs_input
+			void feed(const uint8_t* data, const size_t size, const bool last_input = false);
+
+			//returns how many bytes were written, less than size when the stream
+			//is finished or when it needs more input
+			size_t read(uint8_t* out, const size_t size);
+
+			//decodes everything into out with out itself as the window, needs all of the input fed
+			//returns the decoded size, throws if the output doesnt fit
+			size_t read_all(uint8_t* out, const size_t size);
+
+			bool needs_input() const noexcept;
+			bool finished() const noexcept;
+
+		private:
+			enum class state {zlib_header, block_header, uncompressed, codes, checksum, finished};
+
+			//out has the history before out_end, codes keep being decoded until out_end passes out_limit
+			void step(uint8_t* out, size_t& out_end, const size_t out_limit, const size_t out_size);
+
+			bool enough_input(const size_t bits) noexcept;
+			size_t decode_codes(uint8_t* out, size_t out_pos, const size_t out_limit, const size_t out_size);
+
+			//deflate distances go at most 32kb back
+			static constexpr size_t max_distance = 32768;
+			static constexpr size_t max_length = 258;
+
+			//longest literal/length code with extra bits and distance code with extra bits
+			static constexpr size_t max_symbol_bits = 48;
+			//block type bits, counts, 19 code length codes and 320 lengths with extra bits
+			static constexpr size_t max_dynamic_header_bits = 4560;
+
+			bit_reader _reader;
+			std::vector<uint8_t> _carry;
+
+			bool _last_input = false;
+			bool _needs_input = true;
+
+			bool _verify;
+			uint32_t _adler = 1;
+
+			std::vector<uint8_t> _window;
+			size_t _window_read = 0;
+			size_t _window_end = 0;
+
+			state _state = state::zlib_header;
+			bool _last_block = false;
+			unsigned _uncompressed_left = 0;
+
+			huffman_table _literals;
+			huffman_table _distances;
+		};
+
+		std::vector<uint8_t> deflate(const std::vector<uint8_t>& input_data, const bool verify = false);
+		//for when the decompressed size is known, returns how many bytes were written
+		size_t deflate(const uint8_t* input_data, const size_t input_size, uint8_t* out, const size_t out_size,
+			const bool verify = false);
+
+		//a piece of a stream thats split over several buffers, like png IDAT chunks
+		struct span
+		{
+			const uint8_t* data;
+			size_t size;
+		};
+
+		//if the zlib stream is only stored blocks fills payload with where the uncompressed bytes are
+		//and checksum with the adler32 at the end, false for anything else
+		bool stored_payload(const std::vector<span>& input, std::vector<span>& payload, uint32_t& checksum);
+		//copies a stored_payload out, returns how many bytes were written
+		size_t copy_payload(const std::vector<span>& payload, const uint32_t checksum, uint8_t* out,
+			const size_t out_size, const bool verify);
+
+		//copies a back reference, writes up to copy_slack bytes past the end of it
+		void copy_match(uint8_t* out, const size_t distance, const size_t length) noexcept;
+		constexpr size_t copy_slack = 16;
+
+		void static_huffman_tables(huffman_table& literals, huffman_table& distances);
+		void dynamic_huffman_tables(bit_reader& reader, huffman_table& literals, huffman_table& distances);
+
+		int huffman_distance(bit_reader& reader, int input_bits);
+		int huffman_length(bit_reader& reader, const int input_bits);
+
+		//lsb first bit writer, finished bytes go into data
+		class bit_writer
+		{
+		public:
+			//at most 32 bits at a time
+			void write(const uint32_t bits, const uint8_t num);
+			//pads the last partial byte with zeros
+			void align_byte();
+
+			std::vector<uint8_t> data;
+
+		private:
+			uint64_t _buffer = 0;
+			uint8_t _count = 0;
+		};
+
+		//lz77 with hash chains and lazy matching, every block is written as
+		//whichever of dynamic huffman, fixed huffman or stored comes out smallest
+		class deflater
+		{
+		public:
+			//0 only stores, 1 is a greedy single probe mode for speed, 9 is the slowest and smallest
+			//raw streams have no zlib header and no checksum at the end
+			deflater(const int level = 6, const bool raw = false);
+
+			//data that comes before the stream, matches can point into its last 32kb
+			//has to be set before anything is written
+			void set_dictionary(const uint8_t* data, size_t size);
+
+			void write(const uint8_t* data, const size_t size);
+			//ends the current block with an empty stored block so the output ends on a whole byte
+			void flush();
+			//compresses whats left and ends the stream with the adler32 checksum
+			void finish();
+
+			//adler32 of everything written so far, without the dictionary
+			uint32_t checksum() const noexcept;
+
+			//takes the compressed bytes produced so far
+			std::vector<uint8_t> take_output();
+
+			//compresses data as if it was written next and gives how many bits the block it ends in would take,
+			//then puts everything back so the next candidate is tried on the same history
+			size_t trial_bits(const uint8_t* data, const size_t size);
+
+		private:
+			struct level_config
+			{
+				//chains get shorter once a match this long is found
+				uint16_t good_length;
+				//no lazy search after a match this long
+				uint16_t max_lazy;
+				//stop searching at a match this long
+				uint16_t nice_length;
+				uint16_t max_chain;
+			};
+
+			//every way the pending block can be written, with the size of each in bits
+			struct block_plan
+			{
+				std::vector<int> literal_lengths;
+				std::vector<int> distance_lengths;
+				int literals_used;
+				int distances_used;
+
+				//symbol | extra bits value<<8
+				std::vector<unsigned> length_symbols;
+				std::vector<int> length_code_lengths;
+				int length_codes_used;
+
+				//SIZE_MAX once the start of the block is slid out
+				size_t stored_bits;
+				size_t fixed_bits;
+				size_t dynamic_bits;
+			};
+
+			//a hash head and chain entry as they were before a trial changed them
+			struct hash_change
+			{
+				uint32_t hash;
+				uint16_t slot;
+				uint16_t head;
+				uint16_t prev;
+			};
+
+			//copies data into the window and compresses it, sliding whenever the window fills up
+			void append(const uint8_t* data, const size_t size);
+
+			void process(const bool flushing);
+			//level 1, one hash probe per position and every match is taken as is
+			void process_fast(const bool flushing);
+
+			void insert_hash(const size_t pos);
+			//4 byte hash used by level 1
+			static uint32_t fast_hash(const uint8_t* data) noexcept;
+			unsigned longest_match(size_t candidate, const unsigned prev_length, size_t& match_start) const noexcept;
+			void slide();
+
+			void add_literal(const uint8_t value) noexcept;
+			void add_match(const unsigned length, const unsigned distance) noexcept;
+
+			block_plan plan_block() const;
+			void emit_block(const bool last);
+			void emit_stored(const uint8_t* data, size_t size, const bool last);
+			void emit_codes(const uint16_t* literal_codes, const int* literal_lengths,
+				const uint16_t* distance_codes, const int* distance_lengths);
+
+			static constexpr size_t window_size = 32768;
+			static constexpr uint8_t hash_bits = 15;
+			static constexpr unsigned min_match = 3;
+			static constexpr unsigned max_match = 258;
+			//enough input to always find the longest match and hash the next string
+			static constexpr size_t min_lookahead = max_match+min_match+1;
+			static constexpr size_t max_block_symbols = 16383;
+
+			int _level;
+			bool _raw;
+			level_config _config;
+
+			bit_writer _writer;
+			uint32_t _adler = 1;
+
+			//two windows worth, the lower half is slid out when the upper one fills up
+			std::vector<uint8_t> _window;
+			size_t _window_end = 0;
+			size_t _pos = 0;
+			//goes below 0 once the start of the block is slid out, then it cant be stored anymore
+			ptrdiff_t _block_start = 0;
+
+			//0 means empty so the very first position never starts a match
+			std::vector<uint16_t> _head;
+			std::vector<uint16_t> _prev;
+
+			bool _match_available = false;
+			unsigned _prev_length = 0;
+			size_t _prev_match = 0;
+
+			//literals are stored as is, matches as length | distance<<16
+			std::vector<uint32_t> _symbols;
+			std::array<unsigned, 286> _literal_freqs;
+			std::array<unsigned, 30> _distance_freqs;
+
+			//while a trial runs blocks are only priced and every hash change is kept so it can be undone
+			bool _trial = false;
+			size_t _trial_bits = 0;
+			std::vector<hash_change> _trial_changes;
+			//what _symbols held before the trial, once a block ended during it
+			std::vector<uint32_t> _trial_symbols;
+			//a slide changes every entry, so a trial that slides keeps the window and hash tables whole instead
+			std::vector<uint8_t> _trial_window;
+			std::vector<uint16_t> _trial_head;
+			std::vector<uint16_t> _trial_prev;
+		};
+
+		std::vector<uint8_t> inflate(const std::vector<uint8_t>& input_data, const int level = 6);
+
+		//splits the input into chunks compressed on separate threads, each one primed with the 32kb before it
+		//the output is still one zlib stream, 0 threads uses every core
+		std::vector<uint8_t> inflate_parallel(const std::vector<uint8_t>& input_data, const int level = 6,
+			const unsigned threads_num = 0);
+		constexpr size_t parallel_chunk_size = 128*1024;
+
+		struct inflate_job
 		{
-			int byte;
-			uint_fast8_t bit;
+			const uint8_t* data;
+			size_t size;
+			size_t dictionary_size;
+
+			int level;
+			bool last;
+
+			std::vector<uint8_t> output;
+			uint32_t adler;
+
+			std::promise<void> done;
 		};
+		void inflate_chunk(inflate_job* job);
+
+		//cmf and flg bytes that start a zlib stream
+		std::array<uint8_t, 2> zlib_header(const int level) noexcept;
 
-		std::vector<uint8_t> deflate(const std::vector<uint8_t>& input_data);
+		//continues adler from the previous call, starts at 1
+		//picks the widest vector version the cpu has
+		uint32_t adler32(const uint32_t adler, const uint8_t* data, const size_t size) noexcept;
+		uint32_t adler32_scalar(uint32_t adler, const uint8_t* data, size_t size) noexcept;
+		uint32_t adler32_ssse3(uint32_t adler, const uint8_t* data, size_t size) noexcept;
+		uint32_t adler32_avx2(uint32_t adler, const uint8_t* data, size_t size) noexcept;
+		//checksum of two pieces put together, second_size is the length of the second piece
+		uint32_t adler32_combine(const uint32_t first, const uint32_t second, const size_t second_size) noexcept;
 
-		void uncompressed_block(const std::vector<uint8_t>& input_vec, std::vector<uint8_t>& data_vec, f_pos& pos);
-		void static_huffman_block(const std::vector<uint8_t>& input_vec, std::vector<uint8_t>& data_vec, f_pos& pos);
-		void dynamic_huffman_block(const std::vector<uint8_t>& input_vec, std::vector<uint8_t>& data_vec, f_pos& pos);
+		//code lengths for the given symbol frequencies, none longer than max_length
+		std::vector<int> huffman_lengths(const unsigned* freqs, const size_t count, const uint8_t max_length);
+		//canonical codes for the lengths, bit reversed so they can be written lsb first
+		std::vector<uint16_t> huffman_codes(const std::vector<int>& lengths_vec);
 
-		int huffman_distance(const std::vector<uint8_t>& input_vec, f_pos& pos, int input_bits);
-		int huffman_length(const std::vector<uint8_t>& input_vec, f_pos& pos, const int input_bits);
+		unsigned reverse_bits(unsigned code, const uint8_t length) noexcept;
 
-		void shift_offsets(f_pos& pos, int num);
-		void shift_offset(f_pos& pos);
-		int read_forward(const std::vector<uint8_t>& input_vec, f_pos& pos, int num);
+		//index into length_base for lengths 3-258 and into distance_base for distances 1-32768
+		uint8_t length_index(const unsigned length) noexcept;
+		uint8_t distance_index(const unsigned distance) noexcept;
 
-		std::vector<uint8_t> inflate(const std::vector<uint8_t>& input_data);
+		//start values and extra bits of the length (257-285) and distance (0-29) symbols
+		constexpr std::array<uint16_t, 29> length_base{3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+			35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+		constexpr std::array<uint8_t, 29> length_extra{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+			3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+		constexpr std::array<uint16_t, 30> distance_base{1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+			257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+		constexpr std::array<uint8_t, 30> distance_extra{0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+			7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+		//fixed huffman code lengths from the deflate spec
+		constexpr std::array<int, 288> fixed_literal_lengths = []()
+		{
+			std::array<int, 288> lengths{};
+			for(int i = 0; i < 288; ++i)
+				lengths[i] = i<144 ? 8 : i<256 ? 9 : i<280 ? 7 : 8;
+
+			return lengths;
+		}();
+		constexpr std::array<int, 30> fixed_distance_lengths{5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+			5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5};
+
+		//their canonical codes, bit reversed for writing
+		constexpr std::array<uint16_t, 288> fixed_literal_codes = []()
+		{
+			std::array<uint16_t, 288> codes{};
+			for(int i = 0; i < 288; ++i)
+			{
+				const unsigned code = i<144 ? 0x30+i : i<256 ? 0x190+(i-144) : i<280 ? i-256 : 0xc0+(i-280);
+
+				for(int b = 0; b < fixed_literal_lengths[i]; ++b)
+					codes[i] |= ((code>>b)&0x1)<<(fixed_literal_lengths[i]-1-b);
+			}
+
+			return codes;
+		}();
+		constexpr std::array<uint16_t, 30> fixed_distance_codes = []()
+		{
+			std::array<uint16_t, 30> codes{};
+			for(int i = 0; i < 30; ++i)
+			{
+				for(int b = 0; b < 5; ++b)
+					codes[i] |= ((i>>b)&0x1)<<(4-b);
+			}
+
+			return codes;
+		}();
 
 		//reverses each character bit wise
 		template <typename T>
@@ -138,6 +743,418 @@ namespace yconv
 
 		prefix_vector lengths_to_prefix(const std::vector<int>& lengths_vec);
 	};
+
+	namespace png
+	{
+		//layout the decoded image gets written in, applied to each row as its unfiltered
+		struct output_format
+		{
+			//0 keeps the channels of the file, gray expands to rgb and rgb shrinks to its luma
+			uint8_t channels = 0;
+			//bottom row first
+			bool flip = false;
+			//colors multiplied by alpha, only if the output has an alpha channel
+			bool premultiply = false;
+			//pallete images come out as colors, otherwise as the raw indices
+			bool expand_pallete = true;
+		};
+
+		//verify also checks the adler32 of the image data, chunk crcs are always checked
+		image read(const std::filesystem::path load_path, const bool verify = false);
+		//alpha gets the kind of alpha the output has
+		image read(const std::filesystem::path load_path, const output_format format, alpha_type& alpha,
+			const bool verify = false);
+		//same as read but reading the chunks, inflating and unfiltering happen at the same time
+		//on different threads, passing bands of rows between them
+		image read_pipelined(const std::filesystem::path load_path, const bool verify = false);
+		image read_pipelined(const std::filesystem::path load_path, const output_format format, alpha_type& alpha,
+			const bool verify = false);
+
+		//goes through the chunks up to the image data without reading it
+		image_info probe(const std::filesystem::path load_path);
+
+		//a chunk inside of a mapped file, data is followed by the crc
+		struct chunk
+		{
+			const uint8_t* type;
+			const uint8_t* data;
+			unsigned length;
+
+			bool is(const char* name) const noexcept;
+			//ancillary chunks can be skipped
+			bool ancillary() const noexcept;
+		};
+
+		struct header
+		{
+			unsigned width = 0;
+			unsigned height = 0;
+
+			uint8_t bit_depth = 8;
+			uint8_t values_per_pixel = 1;
+			uint8_t bpp = 1;
+
+			bool pallete_used = false;
+			bool rgb_used = false;
+			bool alpha_channel = false;
+
+			bool interlaced = false;
+		};
+
+		//checks the signature and returns where the first chunk starts
+		size_t chunks_start(const mapped_file& file, const std::filesystem::path& path);
+		//reads the chunk at pos and moves pos past it, false at the end of the file
+		bool next_chunk(const mapped_file& file, size_t& pos, chunk& out);
+		void check_crc(const chunk& checked);
+
+		header parse_header(const chunk& header_chunk);
+		std::vector<uint8_t> parse_pallete(const chunk& pallete_chunk);
+		//alpha of the pallete entries from a tRNS chunk, missing ones are opaque
+		std::vector<uint8_t> parse_pallete_alpha(const chunk& transparency_chunk, const size_t pallete_size);
+
+		//unfilters lines one after another, keeps whatever the next line needs
+		//and writes them out in the output format
+		class line_decoder
+		{
+		public:
+			line_decoder() {};
+			line_decoder(const header& info, const std::vector<uint8_t>& pallete,
+				const std::vector<uint8_t>& pallete_alpha, const output_format format = {});
+
+			//line starts with the filter type byte
+			//the previously decoded row has to stay untouched until this returns
+			void decode(const uint8_t* line, image& img, const unsigned y) noexcept;
+
+			//filter byte included
+			size_t line_size() const noexcept;
+			//bytes per pixel of the output
+			uint8_t bpp() const noexcept;
+
+			//of every row decoded so far
+			alpha_type alpha() const noexcept;
+
+		private:
+			//unfilters into the output row itself, the row above is read from there
+			bool direct() const noexcept;
+
+			//expands the pallete indices if needed, converts the channels and scans the alpha
+			void write_row(const uint8_t* raw, uint8_t* out) noexcept;
+
+			unsigned _width = 0;
+			unsigned _height = 0;
+
+			uint8_t _values_per_pixel = 0;
+			uint8_t _bit_depth = 8;
+			uint8_t _filter_bpp = 0;
+			uint8_t _pallete_channels = 0;
+			uint8_t _bpp = 0;
+
+			bool _pallete_used = false;
+
+			output_format _format;
+
+			size_t _line_size = 0;
+
+			//rgb or rgba entries
+			std::vector<uint8_t> _pallete;
+
+			//unfiltered rows when they cant go straight into the output, zeros above the first one
+			std::vector<uint8_t> _rows[2];
+			int _current_row = 0;
+			std::vector<uint8_t> _expanded;
+			//indices of 1, 2 or 4 bits as bytes
+			std::vector<uint8_t> _unpacked;
+
+			//row above in the output, null before the first one
+			const uint8_t* _previous = nullptr;
+
+			uint8_t _alpha_and = 255;
+			bool _alpha_partial = false;
+		};
+
+		//unfilters every line straight out of the IDAT chunks if theyre only stored deflate blocks
+		//false if theyre compressed, chunk_pos is right after the first chunk
+		bool decode_stored(const mapped_file& file, const chunk& first_chunk, size_t chunk_pos, line_decoder& decoder,
+			image& img, const bool verify);
+
+		//converts a row of pixels between channel counts, premultiplying only matters with alpha in the output
+		void convert_row(const uint8_t* in, const uint8_t in_channels, uint8_t* out, const uint8_t out_channels,
+			const unsigned width, const bool premultiply) noexcept;
+		template<int in_channels, int out_channels>
+		void convert_row(const uint8_t* in, uint8_t* out, const unsigned width, const bool premultiply) noexcept;
+
+		//writes chunks straight into a stream, image data gets split into IDAT chunks of chunk_size
+		//as it comes in so only one chunk is ever held
+		class chunk_writer
+		{
+		public:
+			chunk_writer(std::ostream& stream, const size_t chunk_size = 8192);
+
+			void write_chunk(const char* name, const uint8_t* data, const size_t size);
+
+			//compressed image data, can come in any sized pieces
+			void write_data(const uint8_t* data, size_t size);
+			//writes out the last partial IDAT chunk
+			void finish_data();
+
+		private:
+			void write_chunk(const char* name, const uint8_t* data, const size_t size, const uint32_t crc);
+
+			std::ostream& _stream;
+			size_t _chunk_size;
+
+			std::vector<uint8_t> _data;
+			//of the IDAT chunk being collected, name included
+			uint32_t _crc = 0;
+		};
+
+		//how the filter of each line gets picked, the first five use the same filter for every line
+		//min_sum takes the smallest sum of absolute values, entropy the smallest estimated entropy
+		//and brute_force compresses the line with every filter on the real stream and keeps the smallest
+		enum class filter_strategy {none, sub, up, average, paeth, min_sum, entropy, brute_force};
+
+		//level goes to the deflate compressor, 0 stores and 1 is the fastest
+		//more than 1 thread compresses in parallel chunks, 0 uses every core, brute_force always runs on one
+		//chunk_size is the size of the IDAT chunks
+		//images with 3 or 4 channels and at most 256 colors get saved with a pallete
+		void save(const image_view& img, const std::filesystem::path save_path, const int level = 6,
+			const unsigned threads_num = 1, const filter_strategy strategy = filter_strategy::min_sum,
+			const size_t chunk_size = 8192);
+
+		//an image as indices into a pallete of up to 256 colors
+		struct indexed_image
+		{
+			unsigned width = 0;
+			unsigned height = 0;
+
+			//of the image it came from, with alpha the file always gets a tRNS chunk
+			uint8_t channels = 0;
+
+			//rgba entries, the ones with alpha below 255 come first so tRNS can end early
+			std::vector<uint8_t> pallete;
+			//one byte per pixel
+			std::vector<uint8_t> indices;
+
+			size_t colors() const noexcept;
+			//bits per index in the file, 1, 2, 4 or 8
+			uint8_t bit_depth() const noexcept;
+		};
+
+		//false if the image has more than 256 colors
+		bool find_pallete(const image_view& img, indexed_image& out);
+		//median cut down to at most colors entries, images with fewer colors stay the same
+		indexed_image quantize(const image_view& img, const unsigned colors = 256);
+
+		//writes PLTE, tRNS and the indices packed to their bit depth
+		void save(const indexed_image& img, const std::filesystem::path save_path, const int level = 6,
+			const unsigned threads_num = 1, const filter_strategy strategy = filter_strategy::min_sum,
+			const size_t chunk_size = 8192);
+
+		std::vector<char> create_chunk(const image_view& img, const std::string name, const int level = 6,
+			const unsigned threads_num = 1, const filter_strategy strategy = filter_strategy::min_sum);
+		//magic numbers at the start of every png
+		void write_signature(std::ostream& stream);
+
+		//the chunk data goes between these two, the length is filled in at the end
+		void chunk_header(const std::string name, std::vector<char>& write_data) noexcept;
+		void chunk_ending(std::vector<char>& write_data) noexcept;
+
+		std::vector<uint8_t> header_data(const image_view& img);
+		std::vector<uint8_t> header_data(const indexed_image& img);
+		//the indices packed as a 1 byte per pixel image as wide as a packed row
+		image packed_indices(const indexed_image& img);
+		//moves the entries with alpha below 255 to the front
+		void sort_pallete(indexed_image& img);
+		//filters and compresses one line at a time, or bands of lines on threads_num threads
+		void write_image_data(const image_view& img, chunk_writer& writer, const int level, const unsigned threads_num,
+			const filter_strategy strategy);
+
+		//a band of rows filtered and compressed on its own thread
+		struct encode_job
+		{
+			image_view img;
+			unsigned start_row;
+			unsigned rows;
+
+			int level;
+			filter_strategy strategy;
+			bool last;
+
+			std::vector<uint8_t> filtered;
+			std::promise<void> filtered_done;
+			//the filtered bytes of the band before are the dictionary, empty for the first band
+			const std::vector<uint8_t>* previous;
+			std::future<void> previous_filtered;
+
+			std::vector<uint8_t> output;
+			uint32_t adler;
+
+			std::promise<void> done;
+		};
+		void encode_band(encode_job* job);
+
+		//workers threads with bands of lines, filtered and compressed separately but into one stream
+		void write_image_bands(const image_view& img, chunk_writer& writer, const int level, const unsigned workers,
+			const filter_strategy strategy);
+		size_t band_lines(const size_t line_size) noexcept;
+
+		//about how many filtered bytes go in a band
+		constexpr size_t parallel_band_size = 256*1024;
+
+		typedef std::vector<uint8_t> storage_type;
+
+		//every filter of a row at once, each filtered line starts with its filter type byte
+		class row_filter
+		{
+		public:
+			row_filter() {};
+			row_filter(const size_t size, const uint8_t bpp);
+
+			//previous is null for the first row
+			//sums gets the sum of the absolute values of each filtered line, as signed bytes
+			void filter(const uint8_t* row, const uint8_t* previous, std::array<uint64_t, 5>& sums) noexcept;
+
+			//only fills the line of one filter
+			void filter(const uint8_t filter, const uint8_t* row, const uint8_t* previous) noexcept;
+
+			//filter type byte included
+			const uint8_t* line(const uint8_t filter) const noexcept;
+			size_t line_size() const noexcept;
+
+		private:
+			size_t _size = 0;
+			uint8_t _bpp = 0;
+
+			std::vector<uint8_t> _lines;
+			std::vector<uint8_t> _zeros;
+		};
+
+		//filters the lines of an image one after another with a filter_strategy
+		class filter_selector
+		{
+		public:
+			//stream is where the lines get written, brute_force tries each candidate on it before the line goes in
+			filter_selector(const image_view& img, const filter_strategy strategy, ydeflate::deflater& stream);
+
+			//line y filtered with the picked filter, filter type byte first, valid until the next call
+			//with brute_force it has to be written into the stream before the next line is asked for
+			const uint8_t* line(const unsigned y);
+			size_t line_size() const noexcept;
+
+		private:
+			uint8_t smallest_compressed();
+
+			image_view _img;
+			filter_strategy _strategy;
+
+			size_t _row_size;
+			row_filter _filter;
+
+			ydeflate::deflater& _stream;
+		};
+
+		//bits needed for the bytes of a line if they were coded by their own frequencies
+		float line_entropy(const uint8_t* data, const size_t size) noexcept;
+		uint8_t smallest_entropy(const row_filter& filter) noexcept;
+
+		//the minimum sum of absolute differences heuristic
+		uint8_t smallest_sum(const std::array<uint64_t, 5>& sums) noexcept;
+
+		//writes the row filtered with every filter into out, previous is all zeros for the first row
+		void filter_candidates(const uint8_t* row, const uint8_t* previous, const std::array<uint8_t*, 5>& out,
+			const size_t size, const uint8_t bpp, std::array<uint64_t, 5>& sums) noexcept;
+		void filter_candidates_scalar(const uint8_t* row, const uint8_t* previous, const std::array<uint8_t*, 5>& out,
+			const size_t size, const uint8_t bpp, std::array<uint64_t, 5>& sums) noexcept;
+		void filter_candidates_sse2(const uint8_t* row, const uint8_t* previous, const std::array<uint8_t*, 5>& out,
+			const size_t size, const uint8_t bpp, std::array<uint64_t, 5>& sums) noexcept;
+		//a single filter, sub and up get vectorized by the compiler
+		void filter_row(const uint8_t filter, const uint8_t* row, const uint8_t* previous, uint8_t* out,
+			const size_t size, const uint8_t bpp) noexcept;
+		//adds to sums instead of starting from zero
+		void filter_candidates_range(const uint8_t* row, const uint8_t* previous, const std::array<uint8_t*, 5>& out,
+			const size_t start, const size_t end, const uint8_t bpp, std::array<uint64_t, 5>& sums) noexcept;
+
+		//reverses the filter of one row, in and out can be the same
+		//previous is the unfiltered row above, all zeros for the first row
+		void unfilter_row(const uint8_t filter, const uint8_t* in, uint8_t* out, const uint8_t* previous,
+			const size_t size, const uint8_t bpp) noexcept;
+
+		//bpp_t of 0 reads the bytes per pixel from bpp, anything else is fixed at compile time
+		template<int bpp_t>
+		void unfilter_row_scalar(const uint8_t filter, const uint8_t* in, uint8_t* out, const uint8_t* previous,
+			const size_t size, const uint8_t bpp) noexcept;
+
+		//vectorized filters, sub, average and paeth only for 3 and 4 bytes per pixel
+		void unfilter_up_sse2(const uint8_t* in, uint8_t* out, const uint8_t* previous, const size_t size) noexcept;
+		void unfilter_up_avx2(const uint8_t* in, uint8_t* out, const uint8_t* previous, const size_t size) noexcept;
+		template<int bpp>
+		void unfilter_sub_sse2(const uint8_t* in, uint8_t* out, const size_t size) noexcept;
+		template<int bpp>
+		void unfilter_average_sse2(const uint8_t* in, uint8_t* out, const uint8_t* previous, const size_t size) noexcept;
+		template<int bpp>
+		void unfilter_paeth_sse2(const uint8_t* in, uint8_t* out, const uint8_t* previous, const size_t size) noexcept;
+
+		//slicing by 8 tables, the first one is the usual byte at a time table
+		constexpr std::array<std::array<uint32_t, 256>, 8> crc_table_gen() noexcept
+		{
+			std::array<std::array<uint32_t, 256>, 8> crc_tables{};
+
+			for(uint32_t i = 0; i < 256; ++i)
+			{
+				uint32_t table_num = i;
+				for(int l = 0; l < 8; ++l)
+					table_num = table_num&0x1 ? 0xedb88320^(table_num>>1) : table_num>>1;
+
+				crc_tables[0][i] = table_num;
+			}
+
+			//each table continues the previous one by another zero byte
+			for(int t = 1; t < 8; ++t)
+			{
+				for(int i = 0; i < 256; ++i)
+					crc_tables[t][i] = (crc_tables[t-1][i]>>8)^crc_tables[0][crc_tables[t-1][i]&0xff];
+			}
+
+			return crc_tables;
+		}
+
+		//continues crc from the previous call, starts at 0
+		//picks the carry-less multiply version if the cpu has it
+		uint32_t crc32(const uint32_t crc, const uint8_t* data, const size_t size) noexcept;
+		uint32_t crc32_slicing(uint32_t crc, const uint8_t* data, size_t size) noexcept;
+		uint32_t crc32_clmul(uint32_t crc, const uint8_t* data, size_t size) noexcept;
+
+		uint8_t paeth_predictor(const int left, const int up, const int up_left) noexcept;
+
+	};
+
+	namespace pgm
+	{
+		image read(const std::filesystem::path load_path);
+		void save(const image_view& img, const std::filesystem::path save_path);
+
+		image_info probe(const std::filesystem::path load_path);
+	};
+
+	namespace ppm
+	{
+		void save(const image_view& img, const std::filesystem::path save_path);
+	};
+
+	class model
+	{
+	public:
+		model() {};
+		model(const std::filesystem::path model_path);
+
+		bool read(const std::filesystem::path load_path);
+
+		std::vector<float> vertices;
+		std::vector<int> indices;
+
+	private:
+		bool obj_read(const std::filesystem::path load_path);
+	};
 };
 
 #endif
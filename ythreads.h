@@ -66,6 +66,90 @@ namespace ythreads
 	};
 
 
+	//fixed size queue between threads, pushing waits while its full and popping while its empty
+	template<typename T>
+	class bounded_queue
+	{
+	public:
+		bounded_queue(const size_t capacity);
+
+		//false if the queue got closed
+		bool push(T value);
+		//false once the queue is closed and nothing is left in it
+		bool pop(T& value);
+
+		//wakes up everyone waiting, whats already queued can still be popped
+		void close();
+
+	private:
+		std::mutex _mutex;
+		std::condition_variable _not_empty;
+		std::condition_variable _not_full;
+
+		std::queue<T> _queue;
+		size_t _capacity;
+
+		bool _closed = false;
+	};
+
+
+	template<typename T>
+	bounded_queue<T>::bounded_queue(const size_t capacity)
+	: _capacity(capacity)
+	{
+		assert(capacity>0);
+	}
+
+	template<typename T>
+	bool bounded_queue<T>::push(T value)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+
+			_not_full.wait(lock, [this]{return _queue.size()<_capacity || _closed;});
+
+			if(_closed)
+				return false;
+
+			_queue.push(std::move(value));
+		}
+		_not_empty.notify_one();
+
+		return true;
+	}
+
+	template<typename T>
+	bool bounded_queue<T>::pop(T& value)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+
+			_not_empty.wait(lock, [this]{return !_queue.empty() || _closed;});
+
+			if(_queue.empty())
+				return false;
+
+			value = std::move(_queue.front());
+			_queue.pop();
+		}
+		_not_full.notify_one();
+
+		return true;
+	}
+
+	template<typename T>
+	void bounded_queue<T>::close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			_closed = true;
+		}
+		_not_empty.notify_all();
+		_not_full.notify_all();
+	}
+
+
 	template<typename F, typename A, typename B>
 	pool<F, A, B>::pool(const int threads_num, F call_func)
 	: _call_func(call_func), _threads_num(threads_num), _empty(false)